@@ -0,0 +1,305 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Benchmark of processing chunks of samples into notes, timing each stage of processing
+ * separately on a synthesised guitar note. Sweeps the kernels, sample formats, chunk sizes,
+ * harmonic product spectrum orders and optionally FFT threads, and prints a CSV row per stage of each, so that
+ * runs can be compared to catch regressions. Needs no audio device.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <inttypes.h>
+#include "../../src/freq.h"
+#include "../../src/note.h"
+#include "../../src/synth.h"
+#include "../../src/err.h"
+
+#define SAMPLE_RATE 44100
+// Low E, whose harmonics the harmonic product spectrum has the most work to do on.
+#define SYNTH_FREQ 82.41
+#define DEFAULT_NITERS 50
+// Lowest and highest notes of the tuner by default. The highest decides how far chunks are
+// decimated, and the sliding DFT evaluates the notes between them.
+#define MIN_FREQ 20
+#define MAX_FREQ 1500
+
+// Stage timed by the benchmark after those of fdata_process_chunk().
+#define STAGE_NOTE FDATA_NSTAGES
+#define NSTAGES (FDATA_NSTAGES+1)
+
+struct bench_fmt {
+	const char *name;
+	PaSampleFormat pafmt;
+	sdtype_meta_t *meta;
+};
+
+static struct bench_fmt FMTS[] = {
+	{ "float32", paFloat32, &sdtype_meta_float32 },
+	{ "int32",   paInt32,   &sdtype_meta_int32 },
+	{ "int16",   paInt16,   &sdtype_meta_int16 },
+};
+
+static uint CHUNKSZS[] = { 4096, 8192, 16384, 32768, 65536, 131072 };
+static uint HPS_ORDERS[] = { 1, 3, 5, 7 };
+
+#define NELEMS(a) (sizeof(a)/sizeof(a[0]))
+
+#ifdef GTUNE_FLOAT
+#define PRECISION "float"
+#else
+#define PRECISION "double"
+#endif
+
+/*
+ * Per stage times of the iterations of a benchmark.
+ */
+struct bench_times {
+	uint64_t total[NSTAGES];
+	uint64_t min[NSTAGES];
+};
+
+static uint64_t ns_since(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec-start->tv_sec)*1000000000LL + now.tv_nsec-start->tv_nsec;
+}
+
+/*
+ * bench_run - Time processing niters chunks of a synthesised note
+ *
+ * A new chunk is synthesised before each iteration, untimed. The first chunk is processed
+ * once before timing, to warm up caches.
+ * @decimation: factor to decimate chunks by, 0 for the one the tuner would choose or 1 for none
+ * @decim: set to the factor chunks were decimated by
+ */
+static bool bench_run(const struct fdata_estimator *estimator, struct bench_fmt *fmt, uint chunksz,
+		      uint hps_order, uint nthreads, uint decimation, uint niters,
+		      struct bench_times *t, uint *decim)
+{
+	fdata_t f;
+	struct fdata_params p;
+	note_table_t notes;
+	struct note n;
+	synth_t s;
+	uint64_t stage_ns[FDATA_NSTAGES];
+	struct timespec start;
+	char note[MAX_NOTE_LEN];
+	char *samples;
+	double freq, synth_freq = SYNTH_FREQ;
+	bool success = false;
+
+	fdata_params_default(&p);
+	p.estimator = estimator;
+	p.hps_order = hps_order;
+	p.fft_nthreads = nthreads;
+	p.fft_threads_min = 0;
+	p.min_freq = MIN_FREQ;
+	p.max_freq = MAX_FREQ;
+	p.decimation = decimation;
+	// Benchmark the plans the tuner would use.
+	if (!wisdom_default_path(p.wisdom_path, sizeof(p.wisdom_path)))
+		p.wisdom_path[0] = '\0';
+	if (!fdata_init(&f, SAMPLE_RATE, chunksz, &p))
+		return false;
+	*decim = f.decim;
+	if (!note_table_init(&notes, MIN_FREQ, MAX_FREQ, SAMPLE_RATE/(double)chunksz/NOTE_TABLE_STEPS))
+		goto bench_run_error0;
+	if (!(samples = malloc(chunksz*fmt->meta->samplesz))) {
+		eprintf("failed to allocate samples");
+		goto bench_run_error1;
+	}
+	if (!synth_init(&s, SAMPLE_RATE, &synth_freq, 1, 0, fmt->pafmt))
+		goto bench_run_error2;
+
+	synth_read(&s, samples, chunksz);
+	note_table_lookup(&notes, fdata_process_chunk(&f, samples, 0, fmt->meta, true), &n);
+	note_name(&n, note);
+
+	f.stage_ns = stage_ns;
+	for (int i = 0; i < NSTAGES; ++i) {
+		t->total[i] = 0;
+		t->min[i] = UINT64_MAX;
+	}
+	for (uint i = 0; i < niters; ++i) {
+		synth_read(&s, samples, chunksz);
+		bzero(stage_ns, sizeof(stage_ns));
+		freq = fdata_process_chunk(&f, samples, 0, fmt->meta, true);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		note_table_lookup(&notes, freq, &n);
+		note_name(&n, note);
+		for (int j = 0; j < NSTAGES; ++j) {
+			uint64_t ns = j == STAGE_NOTE ? ns_since(&start) : stage_ns[j];
+
+			t->total[j] += ns;
+			if (ns < t->min[j])
+				t->min[j] = ns;
+		}
+	}
+	success = true;
+
+bench_run_error2:
+	free(samples);
+bench_run_error1:
+	note_table_free(&notes);
+bench_run_error0:
+	fdata_free(&f);
+	return success;
+}
+
+static void print_times(const struct fdata_estimator *estimator, struct bench_fmt *fmt,
+			uint chunksz, uint hps_order, uint nthreads, uint decim, uint niters,
+			struct bench_times *t)
+{
+	uint64_t total = 0, min = 0;
+
+	for (int i = 0; i < NSTAGES; ++i) {
+		printf("%s,%s,%s,%s,%u,%u,%u,%u,%s,%u,%.0f,%" PRIu64 "\n", estimator->name, kern->name,
+		       PRECISION, fmt->name, chunksz, hps_order, nthreads, decim,
+		       i == STAGE_NOTE ? "note" : fdata_stage_names[i], niters,
+		       t->total[i]/(double)niters, t->min[i]);
+		total += t->total[i];
+		min += t->min[i];
+	}
+	printf("%s,%s,%s,%s,%u,%u,%u,%u,total,%u,%.0f,%" PRIu64 "\n", estimator->name, kern->name,
+	       PRECISION, fmt->name, chunksz, hps_order, nthreads, decim, niters,
+	       total/(double)niters, min);
+}
+
+/*
+ * bench_kernels - Run the benchmarks with the kernels in use
+ * @estimator: frequency estimator to benchmark
+ * @chunksz: chunk size to benchmark, or 0 for all of CHUNKSZS
+ * @nthreads: number of threads to also run FFTs on, to compare against a single thread,
+ *	or 1 for only a single thread
+ * @decimation: factor to decimate chunks by, 0 for the one the tuner would choose, which is
+ *	also compared against no decimation, or 1 for none
+ */
+static bool bench_kernels(const struct fdata_estimator *estimator, uint chunksz, uint nthreads,
+			  uint decimation, uint niters)
+{
+	struct bench_times t;
+	uint decims[] = { decimation, 1 };
+	uint decim, chosen = 1;
+	uint nchunkszs = chunksz ? 1 : NELEMS(CHUNKSZS);
+	uint *chunkszs = chunksz ? &chunksz : CHUNKSZS;
+	uint threads[] = { 1, nthreads };
+
+	for (uint c = 0; c < nchunkszs; ++c) {
+		for (uint f = 0; f < NELEMS(FMTS); ++f) {
+			for (uint h = 0; h < NELEMS(HPS_ORDERS); ++h) {
+				for (uint n = 0; n < (nthreads > 1 ? 2 : 1); ++n) {
+					for (uint d = 0; d < (decimation == 0 ? 2 : 1); ++d) {
+						if (!bench_run(estimator, &FMTS[f], chunkszs[c],
+							       HPS_ORDERS[h], threads[n], decims[d],
+							       niters, &t, &decim))
+							return false;
+						// Skip comparing against no decimation when there was none anyway.
+						if (d == 0)
+							chosen = decim;
+						else if (chosen == 1)
+							continue;
+						print_times(estimator, &FMTS[f], chunkszs[c],
+							    HPS_ORDERS[h], threads[n], decim, niters, &t);
+						fflush(stdout);
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void usage(FILE *fp)
+{
+	fprintf(fp,
+		"usage: bench [-e ESTIMATOR] [-K KERNELS] [-c CHUNKSZ] [-T NTHREADS] [-D FACTOR]\n"
+		"             [-n NITERS]\n"
+		"  -e ESTIMATOR frequency estimator to benchmark: hps (default), mpm or sdft (which\n"
+		"              slides over every sample of a chunk, as it would with 1 step a chunk)\n"
+		"  -K KERNELS  kernels to benchmark (default all the CPU supports)\n"
+		"  -c CHUNKSZ  chunk size to benchmark (default powers of 2 from 4096 to 131072)\n"
+		"  -T NTHREADS also benchmark FFTs run on this many threads, to find the chunk size\n"
+		"              multithreading starts to pay off at\n"
+		"  -D FACTOR   decimate chunks by this factor, 1 for none (default the factor the tuner\n"
+		"              chooses for notes up to %d Hz, compared against none)\n"
+		"  -n NITERS   number of chunks timed per benchmark (default %d)\n"
+		"\n"
+		"Prints CSV of the mean and min nanoseconds per chunk of each stage of processing.\n",
+		MAX_FREQ, DEFAULT_NITERS);
+}
+
+static bool parse_uint(const char *s, uint *n)
+{
+	char *end;
+	unsigned long l = strtoul(s, &end, 10);
+
+	if (*s == '\0' || *end != '\0' || l == 0 || l > UINT_MAX) {
+		eprintf("bad number %s", s);
+		return false;
+	}
+	*n = l;
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *kernels = NULL;
+	uint chunksz = 0, nthreads = 1, decimation = 0, niters = DEFAULT_NITERS;
+	struct fdata_params p;
+	int opt;
+
+	err_set_prgname(argv[0]);
+	fdata_params_default(&p);
+	while ((opt = getopt(argc, argv, "e:K:c:T:D:n:h")) != -1) {
+		switch (opt) {
+			case 'e':
+				if (!fdata_parse_estimator(optarg, &p))
+					return EXIT_FAILURE;
+				break;
+			case 'K':
+				kernels = optarg;
+				break;
+			case 'c':
+				if (!parse_uint(optarg, &chunksz))
+					return EXIT_FAILURE;
+				break;
+			case 'T':
+				if (!parse_uint(optarg, &nthreads))
+					return EXIT_FAILURE;
+				break;
+			case 'D':
+				if (!parse_uint(optarg, &decimation))
+					return EXIT_FAILURE;
+				break;
+			case 'n':
+				if (!parse_uint(optarg, &niters))
+					return EXIT_FAILURE;
+				break;
+			case 'h':
+				usage(stdout);
+				return EXIT_SUCCESS;
+			default:
+				usage(stderr);
+				return EXIT_FAILURE;
+		}
+	}
+
+	printf("estimator,kernels,precision,format,chunksz,hps_order,fft_threads,decimation,stage,niters,mean_ns,min_ns\n");
+	if (kernels)
+		return kern_init(kernels) && bench_kernels(p.estimator, chunksz, nthreads, decimation,
+							   niters) ? EXIT_SUCCESS : EXIT_FAILURE;
+	for (uint i = 0; i < kern_nvariants; ++i) {
+		if (!kern_variants[i]->supported())
+			continue;
+		if (!kern_init(kern_variants[i]->name) ||
+		    !bench_kernels(p.estimator, chunksz, nthreads, decimation, niters))
+			return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Example reader of the pitch a tuner publishes with -M PATH. Samples the publication a number
+ * of times a second, as a visualiser redrawing at its own frame rate would, and prints a line
+ * for each new hop it sees. Reading the publication makes no system calls, only the sleeping
+ * between reads does, and never holds up the tuner.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <inttypes.h>
+#include "../../src/pub.h"
+#include "../../src/note.h"
+#include "../../src/err.h"
+
+#define DEFAULT_RATE 10
+
+static void usage(FILE *fp)
+{
+	fprintf(fp,
+		"usage: reader [-r RATE] [-n NHOPS] PATH\n"
+		"  -r RATE     times a second to read the publication (default %d)\n"
+		"  -n NHOPS    exit after printing this many hops (default never)\n"
+		"\n"
+		"Prints the hop, the time from the start of the input and the note, cents and\n"
+		"frequency of each channel whenever a new hop has been published in PATH.\n",
+		DEFAULT_RATE);
+}
+
+static bool parse_uint(const char *s, uint *n)
+{
+	char *end;
+	unsigned long l = strtoul(s, &end, 10);
+
+	if (*s == '\0' || *end != '\0' || l == 0 || l > UINT_MAX) {
+		eprintf("bad number %s", s);
+		return false;
+	}
+	*n = l;
+	return true;
+}
+
+static void print_snapshot(struct pub_snapshot *s)
+{
+	struct note n;
+	char note[MAX_NOTE_LEN];
+
+	printf("%" PRIu64 "\t%.6f", s->hop, s->sample/(double)s->sample_rate);
+	for (uint c = 0; c < s->nchannels && c < PUB_MAX_CHANNELS; ++c) {
+		if (s->channels[c].note < 0) {
+			printf("\t-\t-\t%.3f", s->channels[c].freq);
+			continue;
+		}
+		n.index = s->channels[c].note;
+		n.octave = s->channels[c].octave;
+		note_name(&n, note);
+		printf("\t%.*s\t%+.1f\t%.3f", MAX_NOTE_LEN, note, s->channels[c].cents,
+		       s->channels[c].freq);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+	uint rate = DEFAULT_RATE, nhops = 0, printed = 0;
+	struct pub_snapshot s;
+	struct timespec period;
+	uint64_t last = 0;
+	pub_t p;
+	int opt;
+
+	err_set_prgname(argv[0]);
+	while ((opt = getopt(argc, argv, "r:n:h")) != -1) {
+		switch (opt) {
+			case 'r':
+				if (!parse_uint(optarg, &rate))
+					return EXIT_FAILURE;
+				break;
+			case 'n':
+				if (!parse_uint(optarg, &nhops))
+					return EXIT_FAILURE;
+				break;
+			case 'h':
+				usage(stdout);
+				return EXIT_SUCCESS;
+			default:
+				usage(stderr);
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind != argc-1) {
+		usage(stderr);
+		return EXIT_FAILURE;
+	}
+	if (!pub_open(&p, argv[optind]))
+		return EXIT_FAILURE;
+	period.tv_sec = rate == 1;
+	period.tv_nsec = rate == 1 ? 0 : 1000000000L/rate;
+	while (!nhops || printed < nhops) {
+		if (pub_read(&p, &s) && s.hop != last) {
+			print_snapshot(&s);
+			last = s.hop;
+			++printed;
+		}
+		nanosleep(&period, NULL);
+	}
+	pub_free(&p);
+	return EXIT_SUCCESS;
+}
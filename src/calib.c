@@ -0,0 +1,328 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "calib.h"
+
+// Chunk sizes tried, the powers of 2 between these.
+#define MIN_CHUNKSZ 1024
+#define MAX_CHUNKSZ 65536
+#define MAX_NSTEPS 64
+// Chunks processed of each note before its error is measured, so that estimators that
+// keep state across chunks have settled on it.
+#define NSETTLE 2
+// Hops timed at each number of steps, after one that isn't, to warm up caches.
+#define NTIMED 8
+
+// Harmonic product spectrum orders tried, for the estimators that have one.
+static const uint HPS_ORDERS[] = { 3, 5 };
+// Notes whose error is measured, those of the open strings of a guitar and 2 higher.
+static const double NOTES[] = { 82.41, 110.00, 146.83, 196.00, 246.94, 329.63, 440.00, 880.00 };
+
+#define NELEMS(a) (sizeof(a)/sizeof(a[0]))
+
+void calib_targets_default(struct calib_targets *t)
+{
+	t->cents = 5;
+	t->hz = 0;
+	t->latency = 0.5;
+	t->cpu = 0.5;
+}
+
+bool calib_parse(const char *spec, struct calib_targets *t)
+{
+	char buf[256], *save, *tok, *val, *end;
+	double x;
+
+	if (strlen(spec) >= sizeof(buf)) {
+		eprintf("calibration targets too long");
+		return false;
+	}
+	strcpy(buf, spec);
+	for (tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		if (!(val = strchr(tok, '='))) {
+			eprintf("calibration target %s isn't NAME=VALUE", tok);
+			return false;
+		}
+		*val++ = '\0';
+		x = strtod(val, &end);
+		if (*val == '\0' || *end != '\0' || !(x > 0)) {
+			eprintf("bad calibration target %s=%s", tok, val);
+			return false;
+		}
+		if (strcmp(tok, "cents") == 0) {
+			t->cents = x;
+			t->hz = 0;
+		} else if (strcmp(tok, "hz") == 0) {
+			t->hz = x;
+			t->cents = 0;
+		} else if (strcmp(tok, "latency") == 0) {
+			t->latency = x;
+		} else if (strcmp(tok, "cpu") == 0) {
+			t->cpu = x;
+		} else {
+			eprintf("unknown calibration target %s", tok);
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint64_t ns_since(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec-start->tv_sec)*1000000000LL + now.tv_nsec-start->tv_nsec;
+}
+
+/*
+ * note_error - Get how far a frequency is off the note it should be, in the budget's units
+ */
+static double note_error(const struct calib_targets *t, double freq, double note)
+{
+	if (freq <= 0)
+		return INFINITY;
+	return t->cents ? fabs(1200*log2(freq/note)) : fabs(freq-note);
+}
+
+/*
+ * measure_error - Get the largest error of the notes in the range of valid notes, processed
+ *	a whole chunk at a time
+ */
+static double measure_error(fdata_t *f, struct gtune_params *p, const struct calib_targets *t,
+			    float *samples)
+{
+	synth_t s;
+	double freq = 0, error = 0, mid;
+	uint nnotes = 0;
+
+	for (uint i = 0; i < NELEMS(NOTES); ++i) {
+		if (NOTES[i] < p->min_valid_freq || NOTES[i] > p->max_valid_freq)
+			continue;
+		synth_init(&s, f->sample_rate, &NOTES[i], 1, 0, paFloat32);
+		fdata_reset(f);
+		for (int j = 0; j < NSETTLE; ++j) {
+			synth_read(&s, (char *)samples, f->chunksz);
+			freq = fdata_process_chunk(f, (char *)samples, 0, &sdtype_meta_float32, true);
+		}
+		if (note_error(t, freq, NOTES[i]) > error)
+			error = note_error(t, freq, NOTES[i]);
+		++nnotes;
+	}
+	if (nnotes > 0)
+		return error;
+	// None of the notes are valid, so measure one in the middle of the range instead.
+	mid = sqrt(p->min_valid_freq*p->max_valid_freq);
+	synth_init(&s, f->sample_rate, &mid, 1, 0, paFloat32);
+	fdata_reset(f);
+	for (int j = 0; j < NSETTLE; ++j) {
+		synth_read(&s, (char *)samples, f->chunksz);
+		freq = fdata_process_chunk(f, (char *)samples, 0, &sdtype_meta_float32, true);
+	}
+	return note_error(t, freq, mid);
+}
+
+/*
+ * measure_hop - Get the mean nanoseconds processing a hop of a channel takes, stepping
+ *	through a synthesised note as the tuner does
+ */
+static double measure_hop(fdata_t *f, uint nsteps, float *samples)
+{
+	uint stepsz = f->chunksz/nsteps, head = 0, n;
+	double freq = NOTES[1];
+	struct timespec start;
+	uint64_t total = 0;
+	synth_t s;
+
+	synth_init(&s, f->sample_rate, &freq, 1, 0, paFloat32);
+	synth_read(&s, (char *)samples, f->chunksz);
+	fdata_reset(f);
+	fdata_process_chunk(f, (char *)samples, 0, &sdtype_meta_float32, true);
+	for (int i = 0; i < NTIMED; ++i) {
+		n = f->chunksz-head < stepsz ? f->chunksz-head : stepsz;
+		synth_read(&s, (char *)(samples+head), n);
+		synth_read(&s, (char *)samples, stepsz-n);
+		head = (head+stepsz) % f->chunksz;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		fdata_process_chunk(f, (char *)samples, head, &sdtype_meta_float32, true);
+		total += ns_since(&start);
+	}
+	return total/(double)NTIMED;
+}
+
+/*
+ * calib_nchannels - Get the number of channels each tuner processes
+ */
+static uint calib_nchannels(struct gtune_params *p)
+{
+	if (p->src.nchannels)
+		return p->src.nchannels;
+	return p->src.type == SOURCE_SYNTH ? p->src.synth_nfreqs : 1;
+}
+
+/*
+ * calib_sample_rate - Get the sample rate of the tuners' source, and whether it can be chosen
+ */
+static bool calib_sample_rate(struct gtune_params *p, uint *rate, bool *fixed)
+{
+	wav_t w;
+
+	*rate = p->src.sample_rate;
+	*fixed = p->src.type != SOURCE_MIC && p->src.type != SOURCE_SYNTH;
+	if (p->src.type != SOURCE_WAV)
+		return true;
+	if (!wav_open(&w, p->src.path, 1, 1))
+		return false;
+	*rate = w.sample_rate;
+	wav_close(&w);
+	return true;
+}
+
+bool calib_within(struct calib_config *c, const struct calib_targets *t, double hop_ns,
+		  uint nchannels, uint nserial)
+{
+	c->latency = c->chunksz/(double)c->sample_rate + hop_ns*nserial/1e9;
+	c->cpu = hop_ns*nchannels*c->nsteps*c->sample_rate/c->chunksz/1e9;
+	return c->error <= (t->cents ? t->cents : t->hz) && c->latency <= t->latency &&
+	       c->cpu <= t->cpu;
+}
+
+bool calib_better(const struct calib_config *c, const struct calib_config *best)
+{
+	if (!best->chunksz)
+		return true;
+	if (c->chunksz*(double)best->nsteps*best->sample_rate !=
+	    best->chunksz*(double)c->nsteps*c->sample_rate)
+		return c->chunksz*(double)best->nsteps*best->sample_rate <
+		       best->chunksz*(double)c->nsteps*c->sample_rate;
+	return c->cpu < best->cpu;
+}
+
+/*
+ * calib_try - Measure the settings of a sample rate, chunk size and order, and keep them as
+ *	the best if they keep within the budget and refresh more often than the best so far
+ * @nch: number of channels each tuner processes
+ * @nserial: number of channels processed one after another on a worker of a tuner
+ * @closest: most accurate settings so far, whatever their latency and CPU
+ */
+static void calib_try(struct gtune_params *p, const struct calib_targets *t, uint ntuners,
+		      uint nch, uint nserial, struct calib_config *c, float *samples,
+		      struct calib_config *best, struct calib_config *closest)
+{
+	struct fdata_params freq = p->freq;
+	double error, hop_ns = 0;
+	fdata_t f;
+
+	freq.min_freq = p->min_valid_freq;
+	freq.max_freq = p->max_valid_freq;
+	freq.hps_order = c->hps_order;
+	if (!fdata_init(&f, c->sample_rate, c->chunksz, &freq))
+		return;
+	error = measure_error(&f, p, t, samples);
+	if (error < closest->error) {
+		*closest = *c;
+		closest->error = error;
+	}
+	if (error > (t->cents ? t->cents : t->hz))
+		goto calib_try_done;
+	// The most steps the CPU budget allows refresh the most often. Only estimators that slide
+	// over the new samples take longer for bigger steps, so others are only timed once.
+	for (uint nsteps = MAX_NSTEPS; nsteps >= 1; nsteps /= 2) {
+		if (hop_ns == 0 || f.estimator->update)
+			hop_ns = measure_hop(&f, nsteps, samples);
+		c->nsteps = nsteps;
+		c->error = error;
+		if (!calib_within(c, t, hop_ns, nch*ntuners, nserial))
+			continue;
+		if (calib_better(c, best))
+			*best = *c;
+		break;
+	}
+
+calib_try_done:
+	fdata_free(&f);
+}
+
+bool calib_configure(struct gtune_params *p, const struct calib_targets *t, uint ntuners)
+{
+	struct calib_config best = { 0 }, closest = { .error = INFINITY }, c;
+	const char *units = t->cents ? "cents" : "Hz";
+	uint rates[2], nrates, orders[NELEMS(HPS_ORDERS)], norders;
+	uint nch = calib_nchannels(p), nserial;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	float *samples;
+	bool fixed;
+
+	if (!kern_init(p->kernels) || !calib_sample_rate(p, &rates[0], &fixed))
+		return false;
+	// Halving the sample rate halves the samples converted for the same resolution.
+	rates[1] = rates[0]/2;
+	nrates = fixed ? 1 : 2;
+	// Only try the rates the microphone can capture at.
+	for (uint r = 0; p->src.type == SOURCE_MIC && r < nrates;) {
+		if (mic_supports_rate(rates[r], p->src.fmt, nch, p->src.device))
+			++r;
+		else
+			rates[r] = rates[--nrates];
+	}
+	if (nrates == 0) {
+		eprintf("audio input device can't capture at %u or %u Hz", p->src.sample_rate,
+			p->src.sample_rate/2);
+		return false;
+	}
+	if (p->freq.estimator == &fdata_estimator_mpm) {
+		orders[0] = p->freq.hps_order;
+		norders = 1;
+	} else {
+		memcpy(orders, HPS_ORDERS, sizeof(HPS_ORDERS));
+		norders = NELEMS(HPS_ORDERS);
+	}
+	// The channels are processed in parallel on a thread each, up to one per CPU.
+	nserial = ncpus > 0 && ncpus < nch ? (nch+ncpus-1)/ncpus : 1;
+	if (!(samples = malloc(MAX_CHUNKSZ*sizeof(float)))) {
+		eprintf("failed to allocate calibration samples");
+		return false;
+	}
+	fprintf(stderr, "calibrating...\n");
+	for (uint r = 0; r < nrates; ++r) {
+		for (uint o = 0; o < norders; ++o) {
+			// Every harmonic the harmonic product spectrum multiplies together must be kept.
+			if (rates[r] < 2*p->max_valid_freq*(norders > 1 ? orders[o] : 1))
+				continue;
+			for (uint chunksz = MIN_CHUNKSZ; chunksz <= MAX_CHUNKSZ; chunksz *= 2) {
+				// A chunk takes as long as it is to fill, so longer ones can't keep to the latency.
+				if (chunksz/(double)rates[r] > t->latency)
+					break;
+				c.sample_rate = rates[r];
+				c.chunksz = chunksz;
+				c.hps_order = orders[o];
+				calib_try(p, t, ntuners, nch, nserial, &c, samples, &best, &closest);
+			}
+		}
+	}
+	free(samples);
+
+	if (!best.chunksz) {
+		if (closest.error < INFINITY)
+			eprintf("no settings keep within the calibration targets, the most accurate got within "
+				"%.2f %s with chunks of %u at %u Hz", closest.error, units, closest.chunksz,
+				closest.sample_rate);
+		else
+			eprintf("no settings keep within the calibration targets");
+		return false;
+	}
+	p->src.sample_rate = best.sample_rate;
+	p->chunksz = best.chunksz;
+	p->chunk_nsteps = best.nsteps;
+	p->freq.hps_order = best.hps_order;
+	fprintf(stderr, "calibrated to chunks of %u at %u Hz in %u steps", best.chunksz, best.sample_rate,
+		best.nsteps);
+	if (norders > 1)
+		fprintf(stderr, ", HPS order %u", best.hps_order);
+	fprintf(stderr, ": within %.2f %s, %.3f s latency, %.1f refreshes a second, %.1f%% of a CPU\n",
+		best.error, units, best.latency, best.nsteps*best.sample_rate/(double)best.chunksz,
+		100*best.cpu);
+	return true;
+}
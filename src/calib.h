@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Self-calibration of the tuner's settings against a budget of accuracy, latency and CPU.
+ * Rather than work out the tradeoff between them described at gtune_init() by hand on each
+ * machine, the tuner times processing synthesised notes at each candidate sample rate, chunk
+ * size and harmonic product spectrum order on the machine it's running on, measures how far
+ * off the notes they get, and picks the settings that refresh the most often while keeping
+ * within the budget.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef CALIB_H
+#define CALIB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "gtune.h"
+#include "synth.h"
+#include "wav.h"
+#include "err.h"
+
+/*
+ * Budget the tuner's settings are calibrated to.
+ * @cents: largest error of the frequency of a note in cents, or 0 if it's given in Hz
+ * @hz: largest error of the frequency of a note in Hz, or 0 if it's given in cents
+ * @latency: most seconds from a note being played to its chunk having been processed
+ * @cpu: largest share of a CPU processing may take, 1 for a whole CPU
+ */
+struct calib_targets {
+	double cents;
+	double hz;
+	double latency;
+	double cpu;
+};
+
+/*
+ * Settings of tuners calibration measured.
+ * @error: largest error of the notes, in cents or Hz as the budget is
+ * @latency: seconds from a note being played to its chunk having been processed
+ * @cpu: share of a CPU processing takes across every channel of every tuner
+ */
+struct calib_config {
+	uint sample_rate;
+	uint chunksz;
+	uint nsteps;
+	uint hps_order;
+	double error;
+	double latency;
+	double cpu;
+};
+
+/*
+ * calib_targets_default - Set the budget to its defaults, 5 cents, half a second of latency
+ *	and half a CPU
+ */
+void calib_targets_default(struct calib_targets *t);
+
+/*
+ * calib_parse - Parse a budget from the command line, leaving what it doesn't give as it is
+ * @spec: comma separated list of cents=N or hz=N, latency=SECS and cpu=FRACTION
+ *
+ * Return whether the budget was valid.
+ */
+bool calib_parse(const char *spec, struct calib_targets *t);
+
+/*
+ * calib_within - Work out the latency and CPU of settings from the time a hop takes, and
+ *	whether they keep within a budget
+ * @c: settings whose error has been measured, and whose latency and CPU are set
+ * @hop_ns: nanoseconds processing a hop of a channel takes
+ * @nchannels: number of channels processed across every tuner
+ * @nserial: number of channels processed one after another on a worker of a tuner
+ */
+bool calib_within(struct calib_config *c, const struct calib_targets *t, double hop_ns,
+		  uint nchannels, uint nserial);
+
+/*
+ * calib_better - Get whether settings refresh more often than the best so far, or as often
+ *	for less CPU
+ * @best: best settings so far, with a chunk size of 0 if there are none
+ */
+bool calib_better(const struct calib_config *c, const struct calib_config *best);
+
+/*
+ * calib_configure - Calibrate the sample rate, chunk size, number of steps and harmonic
+ *	product spectrum order of tuners to a budget
+ * @p: parameters of the tuners, whose source, valid notes and processing are calibrated with,
+ *	and which are set to the settings chosen
+ * @ntuners: number of tuners run at once, which share the CPU budget
+ *
+ * The sample rate is only chosen for the microphone and synthesiser, since files decide their
+ * own, and only among those the microphone's input device supports. Prints the settings
+ * chosen and how they measured to stderr. Return false if no settings keep within the budget.
+ */
+bool calib_configure(struct gtune_params *p, const struct calib_targets *t, uint ntuners);
+
+#endif
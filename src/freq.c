@@ -5,6 +5,65 @@
  */
 #include "freq.h"
 
+// Default Kaiser window shape, which has side lobes similar to a Blackman window.
+#define DEFAULT_KAISER_BETA 8.6
+#define DEFAULT_HPS_ORDER 5
+// Smallest chunk size multithreaded FFTs are faster than single-threaded ones for on
+// typical desktop and Pi CPUs. Run make bench with -T to find it for a particular CPU.
+#define DEFAULT_FFT_THREADS_MIN 65536
+// Headroom of the decimated sample rate over twice the highest frequency kept, for the
+// transition band of the low-pass filter between the frequencies kept and those that alias
+// onto them.
+#define DECIM_HEADROOM 1.25
+// Kaiser window shape of the decimation filter, for about 60 dB of attenuation past its
+// transition band, which is plenty for the aliases multiplied into a harmonic product spectrum.
+#define DECIM_KAISER_BETA 5.65
+#define DECIM_ATTENUATION_DB 60
+
+// FFTW's planner isn't thread-safe, so planning and everything else below is serialised
+// between tuners initialised on different threads. Executing plans needs no lock.
+static pthread_mutex_t planner_lock = PTHREAD_MUTEX_INITIALIZER;
+// Whether FFTW's threads have been initialised, which must happen before any other call to FFTW.
+static bool fft_threads_initialised = false;
+// Number of initialised frequency data, such as one per channel, whose plans FFTW's cleanup
+// mustn't pull out from under them until the last is freed.
+static uint nfdata = 0;
+// Path of the wisdom cache file imported into FFTW's wisdom, which is shared by every plan
+// made in the process, so that it's only read once however many frequency data there are.
+static char wisdom_imported[PATH_MAX];
+// Whether plans have been measured since the wisdom was last exported, so that starting
+// more tuners whose plans are all in the cache doesn't rewrite it.
+static bool wisdom_learnt = false;
+
+/*
+ * A plan shared by every frequency data whose FFT is of the same kind, size, planner and number
+ * of threads. A plan is only read once it's made, so is executed on each frequency data's own
+ * arrays with FFTW's new-array execute functions, which any number of threads can do at once.
+ */
+struct fft_shared_plan {
+	fft_plan plan;
+	fdata_fft_kind kind;
+	uint n;
+	unsigned flags;
+	uint nthreads;
+	uint refs;  // Number of frequency data the plan is shared by.
+	struct fft_shared_plan *next;
+};
+
+// Registry of the plans of all frequency data in the process, guarded by the planner lock.
+static struct fft_shared_plan *shared_plans = NULL;
+
+const char *fdata_stage_names[FDATA_NSTAGES] = {
+	"convert", "decimate", "fft", "sdft", "magnitudes", "hps", "nsdf", "argmax"
+};
+
+const struct fdata_estimator *fdata_estimators[] = {
+	&fdata_estimator_hps,
+	&fdata_estimator_mpm,
+	&fdata_estimator_sdft
+};
+const uint fdata_nestimators = sizeof(fdata_estimators)/sizeof(fdata_estimators[0]);
+
 /*
  * nmag - Get the number of magnitudes that need to be processed
  */
@@ -17,79 +76,519 @@ uint nmag(uint chunksz)
 
 static void fdata_free_mallocs(fdata_t *f)
 {
-	free(f->hps);
-	free(f->mag);
-	free(f->c);
-	free(f->norm);
+	FFTW(free)(f->c);
+	FFTW(free)(f->norm);
+	free(f->window);
+	free(f->in);
+	free(f->taps);
+	FFTW(free)(f->acf);
+}
+
+void *fdata_fft_malloc(size_t size)
+{
+	void *p = FFTW(malloc)(size);
+
+	if (!p)
+		eprintf("failed to allocate FFT array: %s", strerror(ENOMEM));
+	return p;
+}
+
+fft_plan fdata_plan(fdata_t *f, fdata_fft_kind kind, uint n, void *in, void *out,
+		    unsigned planner_flags)
+{
+	struct fft_shared_plan *s;
+	char *before, *after;
+
+	for (s = shared_plans; s; s = s->next) {
+		if (s->kind == kind && s->n == n && s->flags == planner_flags &&
+		    s->nthreads == f->fft_nthreads) {
+			++s->refs;
+			return s->plan;
+		}
+	}
+	if (!(s = malloc(sizeof(struct fft_shared_plan)))) {
+		eprintf("failed to allocate FFT plan: %s", strerror(errno));
+		return NULL;
+	}
+	// The arrays are all allocated by FFTW, so have the same alignment as those planned with.
+	// Plans found in the wisdom leave it as it is, while measuring one adds to it.
+	before = FFTW(export_wisdom_to_string)();
+	if (kind == FDATA_FFT_R2C)
+		s->plan = FFTW(plan_dft_r2c_1d)(n, in, out, planner_flags);
+	else
+		s->plan = FFTW(plan_dft_c2r_1d)(n, in, out, planner_flags);
+	after = FFTW(export_wisdom_to_string)();
+	if (!before || !after || strcmp(before, after) != 0)
+		wisdom_learnt = true;
+	free(before);
+	free(after);
+	if (!s->plan) {
+		eprintf("failed to plan FFT of %u samples", n);
+		free(s);
+		return NULL;
+	}
+	s->kind = kind;
+	s->n = n;
+	s->flags = planner_flags;
+	s->nthreads = f->fft_nthreads;
+	s->refs = 1;
+	s->next = shared_plans;
+	shared_plans = s;
+	return s->plan;
+}
+
+/*
+ * fdata_release_plan - Stop sharing a plan, destroying it once it's no longer shared
+ *
+ * Called with the planner lock held.
+ */
+static void fdata_release_plan(fft_plan plan)
+{
+	struct fft_shared_plan **s, *found;
+
+	for (s = &shared_plans; *s; s = &(*s)->next) {
+		if ((*s)->plan != plan)
+			continue;
+		if (--(*s)->refs == 0) {
+			found = *s;
+			*s = found->next;
+			FFTW(destroy_plan)(found->plan);
+			free(found);
+		}
+		return;
+	}
+}
+
+static void fdata_destroy_plans(fdata_t *f)
+{
+	if (f->p)
+		fdata_release_plan(f->p);
+	if (f->ip)
+		fdata_release_plan(f->ip);
 }
 
 void fdata_free(fdata_t *f)
 {
 	if (f) {
-		fftw_destroy_plan(f->p);
-		fftw_cleanup();
+		pthread_mutex_lock(&planner_lock);
+		fdata_destroy_plans(f);
+		// Also does everything FFTW(cleanup) does, including forgetting the imported wisdom.
+		if (--nfdata == 0) {
+			FFTW(cleanup_threads)();
+			fft_threads_initialised = false;
+			wisdom_imported[0] = '\0';
+		}
+		pthread_mutex_unlock(&planner_lock);
+		if (f->estimator->free)
+			f->estimator->free(f);
 		fdata_free_mallocs(f);
 	}
 }
 
-bool fdata_init(fdata_t *f, uint sample_rate, uint chunksz)
+void fdata_params_default(struct fdata_params *p)
+{
+	p->estimator = &fdata_estimator_hps;
+	p->window = WINDOW_HANN;
+	p->kaiser_beta = DEFAULT_KAISER_BETA;
+	p->hps_order = DEFAULT_HPS_ORDER;
+	p->interp = FDATA_INTERP_GAUSSIAN;
+	p->min_freq = 0;
+	p->max_freq = 0;
+	p->decimation = 0;
+	p->planner = FDATA_PLAN_MEASURE;
+	p->wisdom_path[0] = '\0';
+	p->fft_nthreads = 1;
+	p->fft_threads_min = DEFAULT_FFT_THREADS_MIN;
+}
+
+bool fdata_parse_estimator(const char *spec, struct fdata_params *p)
+{
+	for (uint i = 0; i < fdata_nestimators; ++i) {
+		if (strcmp(spec, fdata_estimators[i]->name) == 0) {
+			p->estimator = fdata_estimators[i];
+			return true;
+		}
+	}
+	eprintf("unknown frequency estimator %s", spec);
+	return false;
+}
+
+bool fdata_parse_window(const char *spec, struct fdata_params *p)
+{
+	char *end;
+
+	if (strcmp(spec, "hann") == 0) {
+		p->window = WINDOW_HANN;
+	} else if (strcmp(spec, "blackman-harris") == 0) {
+		p->window = WINDOW_BLACKMAN_HARRIS;
+	} else if (strcmp(spec, "kaiser") == 0) {
+		p->window = WINDOW_KAISER;
+	} else if (strncmp(spec, "kaiser:", 7) == 0) {
+		p->window = WINDOW_KAISER;
+		p->kaiser_beta = strtod(spec+7, &end);
+		if (spec[7] == '\0' || *end != '\0' || p->kaiser_beta < 0) {
+			eprintf("bad Kaiser window beta %s", spec+7);
+			return false;
+		}
+	} else {
+		eprintf("unknown window %s", spec);
+		return false;
+	}
+	return true;
+}
+
+bool fdata_parse_interp(const char *spec, struct fdata_params *p)
+{
+	if (strcmp(spec, "none") == 0) {
+		p->interp = FDATA_INTERP_NONE;
+	} else if (strcmp(spec, "parabolic") == 0) {
+		p->interp = FDATA_INTERP_PARABOLIC;
+	} else if (strcmp(spec, "gaussian") == 0) {
+		p->interp = FDATA_INTERP_GAUSSIAN;
+	} else {
+		eprintf("unknown peak interpolation %s", spec);
+		return false;
+	}
+	return true;
+}
+
+bool fdata_parse_planner(const char *spec, struct fdata_params *p)
+{
+	if (strcmp(spec, "measure") == 0) {
+		p->planner = FDATA_PLAN_MEASURE;
+	} else if (strcmp(spec, "patient") == 0) {
+		p->planner = FDATA_PLAN_PATIENT;
+	} else if (strcmp(spec, "exhaustive") == 0) {
+		p->planner = FDATA_PLAN_EXHAUSTIVE;
+	} else {
+		eprintf("unknown FFT planner %s", spec);
+		return false;
+	}
+	return true;
+}
+
+static unsigned planner_flags(fdata_planner planner)
+{
+	switch (planner) {
+		case FDATA_PLAN_MEASURE:    return FFTW_MEASURE;
+		case FDATA_PLAN_PATIENT:    return FFTW_PATIENT;
+		case FDATA_PLAN_EXHAUSTIVE: return FFTW_EXHAUSTIVE;
+	}
+	return FFTW_MEASURE;
+}
+
+/*
+ * decimation_factor - Get the largest factor samples can be decimated by, a power of 2
+ *	that divides the chunk size, while keeping every frequency the harmonic product
+ *	spectrum multiplies together for fundamentals up to the max frequency
+ */
+static uint decimation_factor(uint sample_rate, uint chunksz, uint hps_order, double max_freq)
+{
+	double highest = max_freq*hps_order;
+	uint factor = 1;
+
+	if (max_freq <= 0)
+		return 1;
+	while (chunksz % (factor*2) == 0 && chunksz/(factor*2) >= 2 &&
+	       sample_rate/(factor*2.0) >= 2*highest*DECIM_HEADROOM)
+		factor *= 2;
+	return factor;
+}
+
+/*
+ * decim_init - Initialise the low-pass filter of decimating by the frequency data's factor
+ * @highest: highest frequency to keep, or 0 for half the decimated sample rate
+ *
+ * The filter passes up to the highest frequency kept, and is down by its transition band
+ * where frequencies start to alias onto those kept, the decimated sample rate less the
+ * highest frequency kept.
+ */
+static bool decim_init(fdata_t *f, double highest)
+{
+	double rate = f->sample_rate/(double)f->decim;
+	double stop, width;
+	uint n;
+
+	if (highest <= 0 || highest > rate/2)
+		highest = rate/2/DECIM_HEADROOM;
+	stop = rate - highest;
+	// Kaiser's estimate of the number of taps for the attenuation and transition band width.
+	width = 2*M_PI*(stop-highest)/f->sample_rate;
+	n = ceil((DECIM_ATTENUATION_DB-8)/(2.285*width)) + 1;
+	n |= 1;
+	f->delay = (n-1)/2;
+	// Zero taps pad the filter to a whole number of vectors of the widest kernels.
+	f->ntaps = (n+15) & ~15u;
+	if (!(f->taps = calloc(f->ntaps, sizeof(real_t))) ||
+	    !(f->in = calloc(f->chunksz + f->ntaps, sizeof(real_t)))) {
+		eprintf("failed to init decimation: %s", strerror(errno));
+		return false;
+	}
+	lowpass_fill(f->taps, n, (highest+stop)/2/f->sample_rate, DECIM_KAISER_BETA);
+	return true;
+}
+
+bool fdata_init(fdata_t *f, uint sample_rate, uint chunksz, struct fdata_params *p)
 {
 	// Zero the pointers set with malloc so that if one fails those that come
 	// after it can safely be freed because they're already NULL pointers.
 	bzero(f, sizeof(fdata_t));
-	if (!(f->norm = malloc(chunksz*sizeof(double))) ||
-	    !(f->c = malloc(chunksz*sizeof(fftw_complex))) ||
-	    !(f->mag = malloc(nmag(chunksz)*sizeof(double))) ||
-	    !(f->hps = malloc(nmag(chunksz)*sizeof(double)))) {
-		eprintf("failed to init frequency data: %s", strerror(errno));
-		fdata_free_mallocs(f);
+	if (p->fft_nthreads < 1) {
+		eprintf("number of FFT threads must be at least 1");
 		return false;
 	}
-	// Use measure option since it's expected that multiple chunks of samples
-	// will be processed and not just one (otherwise estimate would be used).
-	f->p = fftw_plan_dft_r2c_1d(chunksz, f->norm, f->c, FFTW_MEASURE);
 	f->sample_rate = sample_rate;
 	f->chunksz = chunksz;
+	f->estimator = p->estimator;
+	if (f->estimator->update && p->decimation > 1) {
+		eprintf("the %s estimator doesn't decimate", f->estimator->name);
+		return false;
+	}
+	if (f->estimator->update)
+		f->decim = 1;
+	else if (p->decimation)
+		f->decim = p->decimation;
+	else
+		f->decim = decimation_factor(sample_rate, chunksz, p->hps_order, p->max_freq);
+	if (chunksz % f->decim != 0 || chunksz/f->decim < 2) {
+		eprintf("decimation factor %u doesn't divide chunk size %u", f->decim, chunksz);
+		return false;
+	}
+	f->fftsz = chunksz/f->decim;
+	f->restart = true;
+	f->hps_order = p->hps_order;
+	f->interp = p->interp;
+	if (!(f->window = malloc(f->fftsz*sizeof(real_t)))) {
+		eprintf("failed to init frequency data: %s", strerror(errno));
+		return false;
+	}
+	if (f->decim > 1 && !decim_init(f, p->max_freq*p->hps_order)) {
+		fdata_free_mallocs(f);
+		return false;
+	}
+	// A Kaiser window with a beta of 0 is rectangular, leaving the samples as they are.
+	if (f->estimator->windowed)
+		window_fill(f->window, f->fftsz, p->window, p->kaiser_beta);
+	else
+		window_fill(f->window, f->fftsz, WINDOW_KAISER, 0);
+	f->window_scale = 1;
+	f->window_sum = 0;
+	for (uint i = 0; i < f->fftsz; ++i)
+		f->window_sum += f->window[i];
+
+	pthread_mutex_lock(&planner_lock);
+	if (!fft_threads_initialised) {
+		if (!FFTW(init_threads)()) {
+			pthread_mutex_unlock(&planner_lock);
+			eprintf("failed to init FFTW threads");
+			fdata_free_mallocs(f);
+			return false;
+		}
+		fft_threads_initialised = true;
+	}
+	// Measure at least, since it's expected that multiple chunks of samples will be
+	// processed and not just one (otherwise estimate would be used). Plans found by a
+	// previous patient or exhaustive search are reused from the wisdom cache, since FFTW
+	// uses wisdom of the same or a more thorough planner.
+	if (p->wisdom_path[0] && strcmp(p->wisdom_path, wisdom_imported) != 0) {
+		wisdom_import(p->wisdom_path);
+		strcpy(wisdom_imported, p->wisdom_path);
+	}
+	if (p->planner != FDATA_PLAN_MEASURE)
+		fprintf(stderr, "planning FFT of %u samples, this can take a few minutes...\n", f->fftsz);
+	f->fft_nthreads = f->fftsz >= p->fft_threads_min ? p->fft_nthreads : 1;
+	FFTW(plan_with_nthreads)(f->fft_nthreads);
+	if (!f->estimator->init(f, p, planner_flags(p->planner))) {
+		FFTW(plan_with_nthreads)(1);
+		fdata_destroy_plans(f);
+		pthread_mutex_unlock(&planner_lock);
+		if (f->estimator->free)
+			f->estimator->free(f);
+		fdata_free_mallocs(f);
+		return false;
+	}
+	FFTW(plan_with_nthreads)(1);
+	// Not being able to cache the plan only makes the next start up slower.
+	if (p->wisdom_path[0] && wisdom_learnt) {
+		wisdom_export(p->wisdom_path);
+		wisdom_learnt = false;
+	}
+	++nfdata;
+	pthread_mutex_unlock(&planner_lock);
 	return true;
 }
 
+void fdata_reset(fdata_t *f)
+{
+	f->restart = true;
+}
+
+void fdata_stage_time(fdata_t *f, fdata_stage stage, struct timespec *last)
+{
+	struct timespec now;
+
+	if (!f->stage_ns)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	f->stage_ns[stage] += (now.tv_sec-last->tv_sec)*1000000000LL + now.tv_nsec-last->tv_nsec;
+	*last = now;
+}
+
 /*
- * maxi_dbl - Get the index of the maximum double value in an 
- *	array of doubles
- * @a: array of doubles
- * @n: length of array
+ * peak_bin - Estimate the fractional bin of the peak of the magnitudes at a bin found by
+ *	the harmonic product spectrum, using the frequency data's interpolation
+ */
+static double peak_bin(fdata_t *f, uint maxi)
+{
+	fft_complex *c = f->c;
+	uint m = f->nbins;
+	uint k = maxi;
+	real_t l, mid, r;
+
+	if (f->interp == FDATA_INTERP_NONE || k == 0 || k+1 >= m)
+		return maxi;
+	// The magnitudes aren't kept by the harmonic product spectrum, so those of the few bins
+	// around the peak are computed again.
+	l = magnitude(c[k-1]);
+	mid = magnitude(c[k]);
+	r = magnitude(c[k+1]);
+	// The harmonic product spectrum only finds the bin, the shape of the peak is that of the
+	// magnitudes, whose top can be the neighbouring bin when the frequency is about halfway
+	// between the two.
+	if (r > mid || l > mid) {
+		k = r > mid ? k+1 : k-1;
+		if (k == 0 || k+1 >= m)
+			return maxi;
+		l = magnitude(c[k-1]);
+		mid = magnitude(c[k]);
+		r = magnitude(c[k+1]);
+	}
+	if (f->interp == FDATA_INTERP_PARABOLIC)
+		return k + parabolic_offset(l, mid, r);
+	// The log of silence is undefined.
+	if (l <= 0 || mid <= 0 || r <= 0)
+		return k;
+	return k + parabolic_offset(log(l), log(mid), log(r));
+}
+
+/*
+ * hps_band - Find the bins of the valid fundamentals and how many magnitudes the harmonic
+ *	product spectrum of them reads
  *
- * Assumes the array has at least 1 element.
+ * Bins past the highest harmonic of the highest fundamental are never needed, which saves
+ * most of the magnitudes and the products when chunks aren't decimated.
  */
-static uint maxi_dbl(double *a, uint n)
+static void hps_band(fdata_t *f, struct fdata_params *p)
+{
+	uint m = nmag(f->fftsz);
+	// Bins are of the chunk's sample rate, whether decimated or not. See frequency().
+	double hz_per_bin = f->sample_rate/(double)f->chunksz;
+	double lo = p->min_freq > 0 ? floor(p->min_freq/hz_per_bin) : 0;
+	double hi = p->max_freq > 0 ? ceil(p->max_freq/hz_per_bin) : m-1;
+	uint nbins;
+
+	f->max_bin = hi < m-1 ? hi : m-1;
+	f->min_bin = lo < f->max_bin ? lo : f->max_bin;
+	// The peak can be interpolated from the bins either side of a neighbour of the top one.
+	nbins = (f->max_bin+1)*f->hps_order;
+	if (nbins < f->max_bin+3)
+		nbins = f->max_bin+3;
+	f->nbins = nbins < m ? nbins : m;
+}
+
+static bool hps_init(fdata_t *f, struct fdata_params *p, unsigned planner_flags)
 {
-	uint mi = 0;
+	uint m = nmag(f->fftsz);
 
-	while (--n) {
-		if (a[n] > a[mi])
-			mi = n;
+	if (p->hps_order < 1 || p->hps_order > m) {
+		eprintf("harmonic product spectrum order %u out of range 1 to %u", p->hps_order, m);
+		return false;
 	}
-	return mi;
+	hps_band(f, p);
+	if (!(f->norm = fdata_fft_malloc(f->fftsz*sizeof(real_t))) ||
+	    !(f->c = fdata_fft_malloc(f->fftsz*sizeof(fft_complex))))
+		return false;
+	return (f->p = fdata_plan(f, FDATA_FFT_R2C, f->fftsz, f->norm, f->c, planner_flags)) != NULL;
 }
 
-double fdata_process_chunk(fdata_t *f, char *samples, sdtype_meta_t *meta, bool skip_normalise)
+static double hps_estimate(fdata_t *f, struct timespec *last)
 {
 	uint maxi;
-	uint m = nmag(f->chunksz);
-	
+	double bin;
+
+	FFTW(execute_dft_r2c)(f->p, f->norm, f->c);
+	fdata_stage_time(f, FDATA_STAGE_FFT, last);
+	// Use output of FFT to calculate the frequency.
+	maxi = kern->hps_argmax(f->c, f->min_bin, f->max_bin, f->nbins, f->hps_order);
+	fdata_stage_time(f, FDATA_STAGE_HPS, last);
+	bin = peak_bin(f, maxi);
+	// A sine of amplitude A peaks at A*window_sum/2 in its bin.
+	f->peak = 2*magnitude(f->c[(uint)lround(bin)])/(f->window_sum*f->full_scale);
+	fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+
+	return frequency(f->sample_rate, bin, f->chunksz);
+}
+
+const struct fdata_estimator fdata_estimator_hps = {
+	.name = "hps",
+	.windowed = true,
+	.init = hps_init,
+	.estimate = hps_estimate
+};
+
+/*
+ * window_rescale - Scale the window's coefficients to a factor, from the one they're scaled to
+ *
+ * Samples copied as they are get scaled into range -1 to 1 by a window scaled by 1/full_scale,
+ * in the pass that windows them anyway. Otherwise the spectrum of raw int32 samples has
+ * magnitudes whose harmonic product overflows a single-precision real. Full scales are powers
+ * of 2, so rescaling is exact and only done when the sample type changes.
+ */
+static void window_rescale(fdata_t *f, double scale)
+{
+	if (f->window_scale == scale)
+		return;
+	for (uint i = 0; i < f->fftsz; ++i)
+		f->window[i] *= scale/f->window_scale;
+	f->window_scale = scale;
+}
+
+double fdata_process_chunk(fdata_t *f, char *samples, uint start, sdtype_meta_t *meta, bool skip_normalise)
+{
+	struct timespec last;
+	uint n;
+
+	if (f->stage_ns)
+		clock_gettime(CLOCK_MONOTONIC, &last);
+	f->full_scale = f->estimator->update ? meta->full_scale : 1;
+	if (f->estimator->update) {
+		n = (start+f->chunksz-f->last_start) % f->chunksz;
+		if (n == 0 || f->restart)
+			n = f->chunksz;
+		f->estimator->update(f, samples, (start+f->chunksz-n) % f->chunksz, n, meta, &last);
+		f->last_start = start;
+		f->restart = false;
+		return f->estimator->estimate(f, &last);
+	}
 	// Generate normalised values, floating point numbers in range -1 to 1, 
-	// which are input for FFT.
-	if (skip_normalise)
-		normalise_samples_copy(samples, f->chunksz, meta, f->norm);
+	// which are input for FFT. The samples are unrolled from the circular buffer
+	// into the normalised array as they're normalised, and preprocessed further with
+	// the window in the same pass for better and more accurate frequency results.
+	// When decimating, the samples are converted into the middle of the input of the filter,
+	// whose ends stay zero, and the window is run on the decimated samples instead.
+	window_rescale(f, skip_normalise ? 1/meta->full_scale : 1);
+	if (f->decim == 1 && skip_normalise)
+		normalise_samples_copy_ring(samples, f->chunksz, start, meta, f->window, f->norm);
+	else if (f->decim == 1)
+		normalise_samples_ring(samples, f->chunksz, start, meta, f->window, f->norm);
+	else if (skip_normalise)
+		normalise_samples_copy_ring(samples, f->chunksz, start, meta, NULL, f->in+f->delay);
 	else
-		normalise_samples(samples, f->chunksz, meta, f->norm);
-	// Preprocess the values further for better and more accurate frequency results.
-	hanning_window(f->norm, f->chunksz);
-	fftw_execute(f->p);
-	// Use output of FFT to prepare for calculating frequency.
-	magnitudes(f->c, f->mag, m);
-	hps(f->mag, f->hps, m, 5);
-	maxi = maxi_dbl(f->hps, m);
-
-	return frequency(f->sample_rate, maxi, f->chunksz);
+		normalise_samples_ring(samples, f->chunksz, start, meta, NULL, f->in+f->delay);
+	fdata_stage_time(f, FDATA_STAGE_CONVERT, &last);
+	if (f->decim > 1)
+		kern->decimate(f->in, f->taps, f->ntaps, f->decim, f->window, f->norm, f->fftsz);
+	fdata_stage_time(f, FDATA_STAGE_DECIMATE, &last);
+
+	return f->estimator->estimate(f, &last);
 }
@@ -10,36 +10,252 @@
 #define FREQ_H
 
 #include <stdlib.h>
-#include <fftw3.h>
+#include <stdint.h>
 #include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <string.h>
+#include <pthread.h>
 #include "math.h"
 #include "err.h"
 #include "norm.h"
+#include "kern.h"
+#include "wisdom.h"
+
+/*
+ * How hard FFTW searches for the fastest plan of an FFT. Measuring is quick enough for every
+ * start up, while being patient or exhaustive can take minutes but finds faster plans, so is
+ * best run once with a wisdom cache that later start ups reuse the plans of.
+ */
+typedef enum {
+	FDATA_PLAN_MEASURE,
+	FDATA_PLAN_PATIENT,
+	FDATA_PLAN_EXHAUSTIVE
+} fdata_planner;
+
+/*
+ * How the frequency of the peak found by the harmonic product spectrum is estimated from
+ * the magnitudes around it. Without interpolation the frequency is that of the centre of
+ * the peak's bin, so is only as accurate as sample_rate/chunksz. Fitting a parabola to the
+ * peak's bin and its neighbours finds the frequency between bins, to a fraction of a bin, so
+ * that small chunks have the accuracy of large ones. The peak of a windowed sine is close
+ * to a Gaussian, which a parabola fits exactly on a log scale, so that's the most accurate.
+ */
+typedef enum {
+	FDATA_INTERP_NONE,
+	FDATA_INTERP_PARABOLIC,  // Parabola through the magnitudes.
+	FDATA_INTERP_GAUSSIAN  // Parabola through the logs of the magnitudes.
+} fdata_interp;
+
+// Kinds of FFT the estimators plan.
+typedef enum {
+	FDATA_FFT_R2C,  // Real samples to the complex half of their spectrum.
+	FDATA_FFT_C2R  // The inverse, unnormalised.
+} fdata_fft_kind;
+
+struct fdata_estimator;
+
+/*
+ * Parameters for initialising a frequency data.
+ * @estimator: how the frequency of a chunk is estimated, the harmonic product spectrum by
+ *	default. See struct fdata_estimator
+ * @window: shape of the window run on samples before FFT
+ * @kaiser_beta: shape parameter of a Kaiser window
+ * @hps_order: number of harmonics multiplied together by the harmonic product spectrum,
+ *	1 for none
+ * @interp: how the frequency of the peak of the harmonic product spectrum is estimated from
+ *	between bins
+ * @min_freq: lowest fundamental frequency to be found, or 0 for any. Only the sliding DFT
+ *	needs it, and the max frequency, since it only evaluates the notes between them
+ * @max_freq: highest fundamental frequency to be found, or 0 for any up to half the sample rate
+ * @decimation: factor to low-pass filter and downsample samples by before FFT, 1 for none,
+ *	or 0 for the largest that keeps every harmonic the harmonic product spectrum multiplies
+ *	together for fundamentals up to the max frequency. A chunk of samples decimated by a
+ *	factor of 2 only needs an FFT half the size for the same resolution between frequencies.
+ * @planner: how hard FFTW searches for the fastest FFT plan
+ * @wisdom_path: FFTW wisdom cache file (see wisdom.h) to plan from and save newly measured
+ *	plans to, or empty for none
+ * @fft_nthreads: number of threads to run an FFT on, 1 for the calling thread only
+ * @fft_threads_min: smallest chunk size to run an FFT on multiple threads for. Smaller FFTs
+ *	are too quick for splitting them across threads to pay off
+ */
+struct fdata_params {
+	const struct fdata_estimator *estimator;
+	window_type window;
+	double kaiser_beta;
+	uint hps_order;
+	fdata_interp interp;
+	double min_freq;
+	double max_freq;
+	uint decimation;
+	fdata_planner planner;
+	char wisdom_path[PATH_MAX];
+	uint fft_nthreads;
+	uint fft_threads_min;
+};
+
+// Stages of processing a chunk, in order, for timing them.
+typedef enum {
+	FDATA_STAGE_CONVERT,  // Converting samples to reals, normalising and windowing them.
+	FDATA_STAGE_DECIMATE,  // Filtering and downsampling them, and windowing them instead.
+	FDATA_STAGE_FFT,
+	FDATA_STAGE_SDFT,  // Sliding the DFT of the bins of notes over the newly arrived samples.
+	FDATA_STAGE_MAGNITUDES,
+	FDATA_STAGE_HPS,  // Including the magnitudes and peak search it's fused with, see hps_argmax().
+	FDATA_STAGE_NSDF,  // Normalising the autocorrelation into the normalised square difference.
+	FDATA_STAGE_ARGMAX,  // Picking the peak and interpolating it.
+	FDATA_NSTAGES
+} fdata_stage;
+
+extern const char *fdata_stage_names[FDATA_NSTAGES];
 
 struct frequency_data {
+	const struct fdata_estimator *estimator;
 	uint sample_rate;
 	uint chunksz;  // Size of a chunk to process in samples.
-	fftw_plan p;  // Data required by FFT operation.
-	double *norm;  // Normalised array of data between -1 and 1 (input to FFT).
-	fftw_complex *c;  // Complex number output of FFT operation.
-	double *mag;  // Magnitude frequency outputs of complex data.
-	double *hps;  // Harmonic product spectrum array.
-	// (The mag and hps arrays could be combined to save space since they're used 
-	// sequentially and not at the same time, but it would make the code harder to read.)
+	uint decim;  // Factor the chunk is decimated by, 1 for none.
+	uint fftsz;  // Size of the FFT, the decimated chunk size.
+	uint hps_order;
+	fdata_interp interp;
+	uint fft_nthreads;  // Number of threads the FFT plan runs on.
+	fft_plan p;  // Data required by FFT operation.
+	fft_plan ip;  // Inverse FFT of the estimator, if it has one.
+	real_t *window;  // Window coefficients, computed once at init-time for the FFT size.
+	double window_scale;  // Factor the window's coefficients are scaled by, see window_rescale().
+	real_t *in;  // Normalised chunk padded with zeros either side, the input of decimation.
+	real_t *taps;  // Taps of the decimation filter.
+	uint ntaps;
+	uint delay;  // Index of the middle tap of the decimation filter, its delay in samples.
+	real_t *norm;  // Normalised array of data between -1 and 1 (input to FFT).
+	fft_complex *c;  // Complex number output of FFT operation.
+	// Bins of the valid fundamentals, between min_freq and max_freq inclusive, that the peak is
+	// searched for in, and the number of bins whose magnitudes the harmonic product spectrum
+	// of them and the interpolation of their peak read.
+	uint min_bin;
+	uint max_bin;
+	uint nbins;
+	real_t *acf;  // Autocorrelation of the chunk, from the inverse FFT, for estimators that need it.
+	double window_sum;  // Sum of the window's coefficients, the gain of a bin of a sine.
+	double full_scale;  // Largest magnitude of the last chunk's samples as they were estimated from.
+	// Strength of the peak the last chunk's frequency was estimated from, 0 if none was found.
+	// The amplitude of the fundamental relative to full scale for the estimators of the spectrum,
+	// and the clarity, the height of the normalised square difference, for the McLeod pitch method.
+	double peak;
+	// If not NULL, the nanoseconds spent in each stage of processing a chunk are added to it.
+	// NULL by default, so that processing isn't slowed down by reading the clock.
+	uint64_t *stage_ns;
+	void *priv;  // State of the estimator that's its own, such as that of a sliding DFT.
+	uint last_start;  // Start of the last chunk processed, for finding the samples new since.
+	bool restart;  // Whether the next chunk is processed whole, as if none had been before.
 };
 
 typedef struct frequency_data fdata_t;
 
+/*
+ * An estimator of the fundamental frequency of a chunk of samples, the stages of processing
+ * after converting and decimating it, which is selected when a frequency data is initialised.
+ * @name: name of the estimator on the command line
+ * @windowed: whether the chunk is windowed before it's estimated
+ * @init: allocate the norm array and those the estimator needs, and plan its FFTs. Called
+ *	with FFTW's planner lock held, after the FFT size is known. Arrays FFTs are executed on
+ *	are allocated with fdata_fft_malloc() and plans made with fdata_plan(), and executed with
+ *	FFTW's new-array execute functions, since plans are shared
+ * @update: if not NULL, called instead of converting and decimating the whole chunk, with
+ *	only the n samples that arrived since the last chunk, oldest at start. For estimators
+ *	that keep state across chunks and only do work per new sample, which aren't decimated
+ * @estimate: return the frequency of the converted chunk in the norm array, or of the
+ *	samples updated with so far, or 0 if it has none, timing each stage with fdata_stage_time()
+ *	and setting the strength of its peak
+ * @free: if not NULL, free the estimator's state in priv
+ *
+ * Arrays in fdata_t are freed and plans destroyed by fdata_free().
+ */
+struct fdata_estimator {
+	const char *name;
+	bool windowed;
+	bool (*init)(fdata_t *f, struct fdata_params *p, unsigned planner_flags);
+	void (*update)(fdata_t *f, char *samples, uint start, uint n, sdtype_meta_t *meta,
+		       struct timespec *last);
+	double (*estimate)(fdata_t *f, struct timespec *last);
+	void (*free)(fdata_t *f);
+};
+
+/*
+ * The harmonic product spectrum of the magnitudes of an FFT, whose peak is interpolated between
+ * bins. Resolving low notes needs about 4 periods of them in a chunk, and a strong harmonic can
+ * still win over the fundamental by an octave.
+ */
+extern const struct fdata_estimator fdata_estimator_hps;
+
+/*
+ * The McLeod pitch method, which picks the first peak of the normalised square difference of
+ * the chunk that's nearly as high as the highest, from its autocorrelation computed with FFTs.
+ * It locks onto a note in about 2 periods of it, so works on much smaller chunks than the
+ * harmonic product spectrum, and harmonics don't fool it into octave errors. See mpm.c.
+ */
+extern const struct fdata_estimator fdata_estimator_mpm;
+
+/*
+ * A bank of sliding DFTs at the frequencies of the notes between the min and max frequency
+ * and their harmonics, updated with each new sample, whose harmonic product is taken across
+ * the notes. Each hop only costs the new samples times the number of notes, with no full
+ * transforms, so stepping many times per chunk is cheap. See sdft.c.
+ */
+extern const struct fdata_estimator fdata_estimator_sdft;
+
+extern const struct fdata_estimator *fdata_estimators[];
+extern const uint fdata_nestimators;
+
+
+/*
+ * fdata_params_default - Set parameters to their defaults, a Hanning window,
+ *	a harmonic product spectrum of order 5, Gaussian interpolation of its peak, and
+ *	single-threaded measured FFT plans without a wisdom cache
+ */
+void fdata_params_default(struct fdata_params *p);
+
+/*
+ * fdata_parse_estimator - Parse a frequency estimator from the command line into parameters
+ * @spec: name of one of fdata_estimators, "hps", "mpm" or "sdft"
+ *
+ * Return whether the estimator exists.
+ */
+bool fdata_parse_estimator(const char *spec, struct fdata_params *p);
+
+/*
+ * fdata_parse_window - Parse a window description from the command line into parameters
+ * @spec: one of "hann", "blackman-harris", "kaiser" or "kaiser:BETA"
+ *
+ * Return whether the description was valid.
+ */
+bool fdata_parse_window(const char *spec, struct fdata_params *p);
+
+/*
+ * fdata_parse_interp - Parse a peak interpolation from the command line into parameters
+ * @spec: one of "none", "parabolic" or "gaussian"
+ *
+ * Return whether the interpolation was valid.
+ */
+bool fdata_parse_interp(const char *spec, struct fdata_params *p);
+
+/*
+ * fdata_parse_planner - Parse an FFT planner from the command line into parameters
+ * @spec: one of "measure", "patient" or "exhaustive"
+ *
+ * Return whether the planner was valid.
+ */
+bool fdata_parse_planner(const char *spec, struct fdata_params *p);
 
 /*
  * fdata_init - Initialise a new frequency data
  * @sample_rate: sample rate in Hz
  * @chunksz: size of chunk which restricts the samples being processed. Also
  *	the number of samples processed each execution
+ * @p: parameters of processing. See struct fdata_params
  *
  * Return whether the initialisation was successful. Free with with fdata_free.
  */
-bool fdata_init(fdata_t *f, uint sample_rate, uint chunksz);
+bool fdata_init(fdata_t *f, uint sample_rate, uint chunksz, struct fdata_params *p);
 
 /*
  * fdata_free - Free a frequency data initialised with fdata_init
@@ -47,17 +263,57 @@ bool fdata_init(fdata_t *f, uint sample_rate, uint chunksz);
 void fdata_free(fdata_t *f);
 
 
+/*
+ * fdata_reset - Process the next chunk whole, as if no chunk had been before it
+ *
+ * For when the samples of the next chunk don't follow on from those of the last, such as
+ * after samples were lost, so that estimators that update with only the new samples of a
+ * chunk take all of them as new.
+ */
+void fdata_reset(fdata_t *f);
+
+/*
+ * fdata_stage_time - Add the time since the last stage ended to a stage's time, if timing stages
+ * @last: time the last stage ended, updated to now
+ */
+void fdata_stage_time(fdata_t *f, fdata_stage stage, struct timespec *last);
+
+/*
+ * fdata_fft_malloc - Allocate an array for an FFT to be executed on, freed by fdata_free()
+ *
+ * Every array is aligned the same, so that shared plans can be executed on any of them.
+ */
+void *fdata_fft_malloc(size_t size);
+
+/*
+ * fdata_plan - Get the plan of an FFT, shared with every other frequency data in the process
+ *	with one of the same kind, size, planner and number of threads
+ * @n: number of real samples
+ * @in: array of the input, only planned with if the plan is new, which overwrites it
+ * @out: array of the output
+ *
+ * Only called by estimators' init, with the planner lock held. Plans are counted so that
+ * fdata_free() only destroys the last frequency data's. Return NULL if planning failed.
+ */
+fft_plan fdata_plan(fdata_t *f, fdata_fft_kind kind, uint n, void *in, void *out,
+		    unsigned planner_flags);
+
 /*
  * fdata_process_chunk - Process a chunk of samples into a frequency
- * @samples: samples to process 
+ * @samples: samples to process, a circular buffer of chunksz samples
+ * @start: index of the oldest sample in the circular buffer. 0 if the samples aren't wrapped.
+ *	Samples from the start of the last chunk up to this one's are those new since it,
+ *	all of them if the start hasn't moved
  * @meta: metadata describing the numeric data type of a sample. 
- * @skip_normalise: whether to skip normalising the samples because they are already normalised
+ * @skip_normalise: whether to skip normalising the samples because they are already normalised.
+ *	Sliding estimators never normalise, since a few new samples at a time say little of the
+ *	range of them all
  *
- * Return the frequency of the samples.
- * Samples are converted to double as that's the required data type input to the implementation 
- * of FFT in use, but the user could have read a different data type, such as signed 16-bit integers, 
+ * Return the frequency of the samples, or 0 if the estimator found none.
+ * Samples are converted to real_t (double, or float in a single-precision build) as that's the
+ * required data type input to the implementation of FFT in use, but the user could have read a different data type, such as signed 16-bit integers, 
  * or 32-bit floats, etc.
  */
-double fdata_process_chunk(fdata_t *f, char *samples, sdtype_meta_t *meta, bool skip_normalise);
+double fdata_process_chunk(fdata_t *f, char *samples, uint start, sdtype_meta_t *meta, bool skip_normalise);
 
 #endif
@@ -126,159 +126,751 @@ static sdtype_meta_t *pasamplefmt_to_sdtype_meta(PaSampleFormat fmt)
 	}
 }
 
-bool gtune_init(gtune_t *g, uint sample_rate, uint chunksz, uint chunk_nsteps, 
-		double min_valid_freq, double max_valid_freq, PaSampleFormat fmt)
+void gtune_params_default(struct gtune_params *p)
+{
+	bzero(p, sizeof(struct gtune_params));
+	p->src.type = SOURCE_MIC;
+	p->src.sample_rate = 44100;
+	p->src.fmt = paFloat32;
+	p->src.synth_secs = 10;
+	p->chunksz = 32768;
+	p->chunk_nsteps = 4;
+	p->min_valid_freq = 20;
+	p->max_valid_freq = 1500;
+	p->fps = 30;
+	fdata_params_default(&p->freq);
+	// Without a cache directory plans are measured at every start up.
+	if (!wisdom_default_path(p->freq.wisdom_path, sizeof(p->freq.wisdom_path)))
+		p->freq.wisdom_path[0] = '\0';
+}
+
+/*
+ * gtune_free_channels - Free the channels initialised so far and the buffer of frames
+ */
+static void gtune_free_channels(gtune_t *g)
+{
+	for (uint c = 0; c < g->nchannels; ++c) {
+		free(g->channels[c].samples);
+		fdata_free(&g->channels[c].freq);
+	}
+	free(g->channels);
+	free(g->frames);
+}
+
+/*
+ * gtune_init_channels - Initialise the processing of each channel of the source
+ * @p: parameters of processing samples into frequencies, shared by all channels
+ */
+static bool gtune_init_channels(gtune_t *g, struct fdata_params *p)
+{
+	struct fdata_params freq = *p;
+	struct gtune_channel *ch;
+
+	// Notes outside the valid range aren't wanted anyway, so the spectrum above the harmonics
+	// of the highest needn't be kept, and a sliding DFT needn't evaluate them.
+	freq.min_freq = g->min_valid_freq;
+	freq.max_freq = g->max_valid_freq;
+	if (!(g->channels = calloc(g->src.nchannels, sizeof(struct gtune_channel)))) {
+		eprintf("failed to allocate channels: %s", strerror(errno));
+		return false;
+	}
+	for (; g->nchannels < g->src.nchannels; ++g->nchannels) {
+		ch = &g->channels[g->nchannels];
+		if (!fdata_init(&ch->freq, g->src.sample_rate, g->chunksz, &freq))
+			goto gtune_init_channels_error;
+		if (!(ch->samples = malloc(g->chunksz*g->meta->samplesz))) {
+			eprintf("failed to allocate samples: %s", strerror(errno));
+			fdata_free(&ch->freq);
+			goto gtune_init_channels_error;
+		}
+		ch->freq.stage_ns = ch->stage_ns;
+		init_note(ch->note);
+		// The first channel's plan stays in memory for the rest of the channels to reuse,
+		// so there's no need to go back to the wisdom cache.
+		freq.wisdom_path[0] = '\0';
+	}
+	if (g->nchannels > 1 && !(g->frames = malloc(g->chunksz*g->nchannels*g->meta->samplesz))) {
+		eprintf("failed to allocate frames: %s", strerror(errno));
+		goto gtune_init_channels_error;
+	}
+	return true;
+
+gtune_init_channels_error:
+	gtune_free_channels(g);
+	return false;
+}
+
+/*
+ * gtune_nworkers - Get the number of worker threads to process channels on
+ *
+ * There's a thread per channel, including the thread reading the source, so that processing
+ * all channels takes as long as processing one while there are enough CPUs for them.
+ */
+static uint gtune_nworkers(uint nchannels)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (ncpus > 0 && ncpus < nchannels)
+		return ncpus-1;
+	return nchannels-1;
+}
+
+/*
+ * displaying - Get whether the tuner's notes are shown on the live display, rather than
+ *	printed as a pitch track or written as records
+ */
+static bool displaying(gtune_t *g)
+{
+	return !g->offline && g->output == STREAM_NONE;
+}
+
+bool gtune_init(gtune_t *g, struct gtune_params *p)
 {
 	norm_assert();
 	bzero(g, sizeof(gtune_t));
 
-	if (!nsteps_valid(chunk_nsteps) || !chunksz_valid(chunksz) ||
-	    !frequencies_valid(min_valid_freq, max_valid_freq) ||
-	    !sample_rate_valid(sample_rate))
+	if (!nsteps_valid(p->chunk_nsteps) || !chunksz_valid(p->chunksz) ||
+	    !frequencies_valid(p->min_valid_freq, p->max_valid_freq))
 		return false;
-	g->chunk_stepsz = chunk_stepsz(chunksz, chunk_nsteps);
-	if (!stepping_valid(chunk_nsteps, chunksz, g->chunk_stepsz))
+	g->chunk_stepsz = chunk_stepsz(p->chunksz, p->chunk_nsteps);
+	if (!stepping_valid(p->chunk_nsteps, p->chunksz, g->chunk_stepsz))
 		return false;
 
-	g->chunksz = chunksz;
-	g->chunk_nsteps = chunk_nsteps;
-	g->min_valid_freq = min_valid_freq;
-	g->max_valid_freq = max_valid_freq;
-
-	if (!fdata_init(&g->freq, sample_rate, chunksz))
+	g->chunksz = p->chunksz;
+	g->chunk_nsteps = p->chunk_nsteps;
+	g->min_valid_freq = p->min_valid_freq;
+	g->max_valid_freq = p->max_valid_freq;
+	g->offline = p->offline;
+	g->stats_path = p->stats_path;
+	g->label = p->label;
+	g->output = p->output;
+	g->index = p->index;
+	g->flush_ns = p->fps ? 1000000000L/p->fps : 0;
+	atomic_init(&g->stopping, false);
+	stats_init(&g->stats);
+	g->stats_seen = atomic_load(&stats_requests);
+	atomic_init(&g->stats_answered, g->stats_seen);
+	if (!kern_init(p->kernels))
 		return false;
-	// Set up sample data type before initialising mic since it uses the sample data type.
-	if (!(g->meta = pasamplefmt_to_sdtype_meta(fmt)) ||
-	    !(g->samples = malloc(g->chunksz*g->meta->samplesz))) {
-		fdata_free(&g->freq);
+
+	// The source is initialised first since a file source decides the sample rate and format,
+	// but it isn't started until gtune_start().
+	if ((p->src.type != SOURCE_WAV && !sample_rate_valid(p->src.sample_rate)) ||
+	    !source_init(&g->src, &p->src, g->chunk_stepsz))
 		return false;
+	g->pafmt = g->src.fmt;
+	if (!sample_rate_valid(g->src.sample_rate) || !(g->meta = pasamplefmt_to_sdtype_meta(g->pafmt)))
+		goto gtune_init_error0;
+	// Binary records number a channel in a byte, so more would wrap around to the wrong ones.
+	if (p->output == STREAM_BINARY && g->src.nchannels > UINT8_MAX) {
+		eprintf("can't write binary records of more than %d channels", UINT8_MAX);
+		goto gtune_init_error0;
 	}
-	g->pafmt = fmt;
-	if (!mic_init(&g->mic, sample_rate, g->chunk_stepsz, fmt)) {
-		fdata_free(&g->freq);
-		free(g->samples);
-		return false;
+	if (!gtune_init_channels(g, &p->freq))
+		goto gtune_init_error0;
+	// The frequencies of chunks are those of their bins, or interpolated between them.
+	if (!note_table_init(&g->notes, g->min_valid_freq, g->max_valid_freq,
+			     g->src.sample_rate/(double)g->chunksz/NOTE_TABLE_STEPS))
+		goto gtune_init_error1;
+	if (!pool_init(&g->pool, gtune_nworkers(g->nchannels)))
+		goto gtune_init_error2;
+	if (displaying(g) && !render_init(&g->render, g->nchannels, g->label, p->fps))
+		goto gtune_init_error3;
+	if (p->pub_path) {
+		if (g->nchannels > PUB_MAX_CHANNELS) {
+			eprintf("can't publish the pitch of more than %d channels", PUB_MAX_CHANNELS);
+			goto gtune_init_error4;
+		}
+		if (!pub_init(&g->pub, p->pub_path))
+			goto gtune_init_error4;
 	}
-	init_note(g->note);
+	if (!tribuf_init(&g->stats_snaps, sizeof(struct stats_snapshot)))
+		goto gtune_init_error5;
 	return true;
+
+gtune_init_error5:
+	pub_free(&g->pub);
+gtune_init_error4:
+	render_free(&g->render);
+gtune_init_error3:
+	pool_free(&g->pool);
+gtune_init_error2:
+	note_table_free(&g->notes);
+gtune_init_error1:
+	gtune_free_channels(g);
+gtune_init_error0:
+	source_cleanup(&g->src);
+	return false;
 }
 
 void gtune_cleanup(gtune_t *g)
 {
 	if (g) {
-		free(g->samples);
-		mic_cleanup(&g->mic);
-		fdata_free(&g->freq);
+		pool_free(&g->pool);
+		source_cleanup(&g->src);
+		gtune_free_channels(g);
+		note_table_free(&g->notes);
+		render_free(&g->render);
+		pub_free(&g->pub);
+		tribuf_free(&g->stats_snaps);
 	}
 }
 
-static void print_header(void)
+/*
+ * print_header - Print the header of the live display, which is shared by all the tuners
+ *	when they're labelled
+ */
+static void print_header(gtune_t *g)
 {
-	printf("LAST NOTE    CUR FREQ\n");
+	if (g->label) {
+		printf("SOURCE: LAST NOTE, CENTS AND CUR FREQ OF EACH CHANNEL\n");
+		return;
+	}
+	if (g->nchannels == 1)
+		printf("LAST NOTE  CENTS  CUR FREQ\n");
+	else
+		printf("LAST NOTE, CENTS AND CUR FREQ OF CHANNELS 1 TO %u\n", g->nchannels);
 	printf("waiting for data...");
 	fflush(stdout);
 }
 
-static void print_note(char *note, double freq)
+/*
+ * publish_notes - Hand the notes of all channels to the live display, which draws them on
+ *	a thread of its own
+ */
+static void publish_notes(gtune_t *g)
 {
-	printf("\r%s          %07.3f", note, freq);
-	fflush(stdout);
+	struct render_note *frame = render_frame(&g->render);
+	struct gtune_channel *ch = g->channels;
+
+	for (uint c = 0; c < g->nchannels; ++c) {
+		memcpy(frame[c].note, ch[c].note, MAX_NOTE_LEN);
+		frame[c].cents = ch[c].cents;
+		frame[c].freq = ch[c].note_freq;
+	}
+	render_publish(&g->render);
 }
 
 /*
- * gtune_freq - Calculate and print a frequency and its note
- * @samples: samples to process. Processes chunksz amount of input samples as 
- *	specified at init-time of gtune
+ * print_track_header - Print the header of the pitch track output in offline mode
+ *
+ * There's only a channel column for sources with multiple channels, and only a source column
+ * for labelled tuners, which always have a channel column since they may differ in channels.
+ */
+static void print_track_header(gtune_t *g)
+{
+	if (g->label)
+		printf("source\ttime\tchannel\tfreq\tnote\tcents\n");
+	else
+		printf(g->nchannels == 1 ? "time\tfreq\tnote\tcents\n" :
+		       "time\tchannel\tfreq\tnote\tcents\n");
+}
+
+/*
+ * print_track - Print a line of the pitch track output in offline mode
+ * @t: time in seconds since the start of the input of the end of the processed chunk
+ * @c: index of the channel of the frequency
+ * @note: note of the frequency, or NULL if the frequency isn't a valid note
+ * @cents: cents the frequency is off the note
+ */
+static void print_track(gtune_t *g, double t, uint c, char *note, double freq, double cents)
+{
+	int len = 0;
+
+	if (note) {
+		// Trim the padding spaces.
+		while (len < MAX_NOTE_LEN && note[len] != ' ')
+			++len;
+	}
+	if (g->label)
+		printf("%s\t", g->label);
+	printf("%.6f\t", t);
+	if (g->nchannels > 1 || g->label)
+		printf("%u\t", c+1);
+	printf("%.3f\t%.*s\t", freq, len ? len : 1, len ? note : "-");
+	if (len)
+		printf("%+.1f\n", cents);
+	else
+		printf("-\n");
+}
+
+/*
+ * write_records - Write a record of each channel's last processed chunk to the stream
+ *
+ * A live stream is flushed at most fps times a second, so that records reach readers soon
+ * after their chunks, while still many to a write at high rates of hops.
+ */
+static void write_records(gtune_t *g)
+{
+	struct stream_record r = {
+		.sample = g->nread,
+		.read_ns = g->last_read.tv_sec*1000000000LL + g->last_read.tv_nsec,
+		.sample_rate = g->src.sample_rate,
+		.source = g->index
+	};
+	struct timespec now = g->last_flush;
+	struct gtune_channel *ch;
+
+	for (uint c = 0; c < g->nchannels; ++c) {
+		ch = &g->channels[c];
+		r.proc_ns = 0;
+		for (int i = 0; i < FDATA_NSTAGES; ++i)
+			r.proc_ns += ch->stage_ns[i];
+		r.freq = ch->note_freq;
+		r.cents = ch->cur.cents;
+		r.peak = ch->freq.peak;
+		r.channel = c+1;
+		r.note = ch->cur.index;
+		r.octave = ch->cur.octave;
+		stream_write(stdout, g->output, &r, g->label);
+	}
+	if (!g->offline && stats_ns_since(&now) >= g->flush_ns) {
+		fflush(stdout);
+		g->last_flush = now;
+	}
+}
+
+/*
+ * publish_pitch - Publish the pitch of every channel's last processed chunk for other
+ *	processes to read
  */
-static void gtune_freq(gtune_t *g, char *samples)
+static void publish_pitch(gtune_t *g)
 {
-	double note_freq;
+	struct pub_snapshot s = {
+		.hop = g->hops,
+		.sample = g->nread,
+		.read_ns = g->last_read.tv_sec*1000000000LL + g->last_read.tv_nsec,
+		.sample_rate = g->src.sample_rate,
+		.nchannels = g->nchannels
+	};
+	struct gtune_channel *ch;
+
+	for (uint c = 0; c < g->nchannels; ++c) {
+		ch = &g->channels[c];
+		s.channels[c].freq = ch->note_freq;
+		s.channels[c].peak = ch->freq.peak;
+		s.channels[c].note = ch->cur.index;
+		// A chunk without a note leaves the cents and octave of the last one.
+		if (ch->cur.index >= 0) {
+			s.channels[c].cents = ch->cur.cents;
+			s.channels[c].octave = ch->cur.octave;
+		}
+	}
+	pub_publish(&g->pub, &s);
+}
+
+/*
+ * snapshot_stats - Copy the statistics into a snapshot for the signal thread to print, answering
+ *	a request for them
+ * @requests: number of requests answered by the snapshot
+ */
+static void snapshot_stats(gtune_t *g, uint requests)
+{
+	struct stats_snapshot *snap = tribuf_back(&g->stats_snaps);
+
+	snap->stats = g->stats;
+	source_lost(&g->src, &snap->overruns, &snap->overflows);
+	tribuf_publish(&g->stats_snaps);
+	atomic_store_explicit(&g->stats_answered, requests, memory_order_release);
+}
+
+void gtune_print_stats(gtune_t *g)
+{
+	static const struct timespec poll = { 0, 1000000 };
+	uint want = atomic_load(&stats_requests), answered;
+	struct stats_snapshot *snap;
+	char tmp[PATH_MAX];
+	FILE *fp;
+
+	// Polled every millisecond, for up to a second.
+	for (int i = 0;; ++i) {
+		answered = atomic_load_explicit(&g->stats_answered, memory_order_acquire);
+		// The counts wrap around, so compare how far apart they are. A later request's
+		// snapshot answers this one too.
+		if ((int)(answered-want) >= 0)
+			break;
+		if (i == 1000 || atomic_load_explicit(&g->stopping, memory_order_relaxed))
+			return;
+		nanosleep(&poll, NULL);
+	}
+	tribuf_take(&g->stats_snaps);
+	snap = tribuf_front(&g->stats_snaps);
+	if (!g->stats_path) {
+		// Keep the snapshot together, apart from the other output to stderr.
+		flockfile(stderr);
+		if (g->label)
+			fprintf(stderr, "%s:\n", g->label);
+		stats_print(stderr, &snap->stats, snap->overruns, snap->overflows);
+		funlockfile(stderr);
+		return;
+	}
+	// Write to a temporary file renamed over the stats file, so that it's never read half written.
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", g->stats_path) >= sizeof(tmp) ||
+	    !(fp = fopen(tmp, "w"))) {
+		eprintf("failed to open stats file %s.tmp", g->stats_path);
+		return;
+	}
+	if (g->label)
+		fprintf(fp, "%s:\n", g->label);
+	stats_print(fp, &snap->stats, snap->overruns, snap->overflows);
+	if (fclose(fp) != 0 || rename(tmp, g->stats_path) != 0)
+		eprintf("failed to write stats file %s: %s", g->stats_path, strerror(errno));
+}
+
+/*
+ * deinterleave - Copy a channel's samples out of interleaved frames
+ * @c: index of the channel's sample in each frame
+ * @out: array to store the channel's samples into
+ * @n: number of frames
+ */
+static void deinterleave(const char *frames, uint nchannels, uint c, uint samplesz, char *out, uint n)
+{
+	switch (samplesz) {
+		case sizeof(uint32_t):
+			for (uint i = 0; i < n; ++i)
+				((uint32_t *)out)[i] = ((const uint32_t *)frames)[i*nchannels + c];
+			break;
+		case sizeof(uint16_t):
+			for (uint i = 0; i < n; ++i)
+				((uint16_t *)out)[i] = ((const uint16_t *)frames)[i*nchannels + c];
+			break;
+		default:
+			for (uint i = 0; i < n; ++i)
+				memcpy(out + i*samplesz, frames + (i*nchannels + c)*samplesz, samplesz);
+	}
+}
+
+/*
+ * gtune_read - Read frames of samples from the tuner's source into the channels' samples
+ * @head: index in the channels' arrays of samples to read into
+ * @readsz: number of frames to read, which mustn't run past the end of the arrays
+ *
+ * A single channel is read straight into its samples, otherwise the interleaved frames are
+ * split up between the channels. Sources that aren't realtime, such as files, are read as
+ * fast as possible in offline mode, otherwise they're paced to the rate they would have been
+ * recorded at so that the display can be followed. Return false if the source has come to an end.
+ */
+static bool gtune_read(gtune_t *g, uint head, uint readsz)
+{
+	uint samplesz = g->meta->samplesz;
+	struct timespec t;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	if (g->nchannels == 1) {
+		if (!source_read(&g->src, g->channels[0].samples+head*samplesz, readsz))
+			return false;
+	} else {
+		if (!source_read(&g->src, g->frames, readsz))
+			return false;
+		for (uint c = 0; c < g->nchannels; ++c)
+			deinterleave(g->frames, g->nchannels, c, samplesz,
+				     g->channels[c].samples+head*samplesz, readsz);
+	}
+	hist_add(&g->stats.stages[STATS_READ], stats_ns_since(&t));
+	g->nread += readsz;
+	if (g->output != STREAM_NONE || g->pub.page)
+		clock_gettime(CLOCK_REALTIME, &g->last_read);
+
+	if (!g->offline && !source_realtime(&g->src)) {
+		secs = g->nread/(double)g->src.sample_rate;
+		t.tv_sec = g->start.tv_sec + (time_t)secs;
+		t.tv_nsec = g->start.tv_nsec + (secs-(time_t)secs)*1e9;
+		if (t.tv_nsec >= 1000000000) {
+			++t.tv_sec;
+			t.tv_nsec -= 1000000000;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+			;
+	}
+	return true;
+}
+
+/*
+ * gtune_channel_freq - Calculate the frequency of a channel's circular buffer of samples,
+ *	starting from the oldest sample at the tuner's head
+ *
+ * Run on the pool of workers for each channel, in parallel with the other channels.
+ */
+static void gtune_channel_freq(void *arg, uint c)
+{
+	gtune_t *g = arg;
+	struct gtune_channel *ch = &g->channels[c];
 
 	// TODO should only be skipping normalisation for paFloat32 since it's already normalised, but
 	// the not already normalised int types seem to work better without it
-	note_freq = fdata_process_chunk(&g->freq, samples, g->meta, true);
+	bzero(ch->stage_ns, sizeof(ch->stage_ns));
+	ch->note_freq = fdata_process_chunk(&ch->freq, ch->samples, g->head, g->meta, true);
+}
 
-	if (note_freq >= g->min_valid_freq && note_freq <= g->max_valid_freq)
-		note_from_freq(note_freq, g->note);
-	print_note(g->note, note_freq);
+/*
+ * note_valid - Get whether a frequency is in the range considered a note
+ */
+static bool note_valid(gtune_t *g, double freq)
+{
+	return freq >= g->min_valid_freq && freq <= g->max_valid_freq;
 }
 
 /*
- * gtune - Process samples without a step
+ * gtune_freq - Calculate and print the frequency and note of every channel
+ *
+ * The channels' samples are circular buffers of chunksz amount of input samples as specified
+ * at init-time of gtune, with the oldest at the head. The stage histograms get the times of
+ * each channel.
  */
-static void gtune(gtune_t *g)
+static void gtune_freq(gtune_t *g)
+{
+	stats_t *s = &g->stats;
+	struct gtune_channel *ch;
+	struct timespec t;
+	double t_end = g->nread/(double)g->src.sample_rate;
+	uint requests;
+
+	pool_run(&g->pool, gtune_channel_freq, g, g->nchannels);
+	for (uint c = 0; c < g->nchannels; ++c) {
+		for (int i = 0; i < FDATA_NSTAGES; ++i)
+			hist_add(&s->stages[STATS_FDATA+i], g->channels[c].stage_ns[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	for (uint c = 0; c < g->nchannels; ++c) {
+		ch = &g->channels[c];
+		if (note_valid(g, ch->note_freq)) {
+			note_table_lookup(&g->notes, ch->note_freq, &ch->cur);
+			note_name(&ch->cur, ch->note);
+			ch->cents = ch->cur.cents;
+		} else {
+			ch->cur.index = -1;
+		}
+	}
+	hist_add(&s->stages[STATS_NOTE], stats_ns_since(&t));
+	++g->hops;
+	if (g->pub.page)
+		publish_pitch(g);
+	if (g->output != STREAM_NONE) {
+		// Keep the records of tuners writing at the same time apart.
+		flockfile(stdout);
+		write_records(g);
+		funlockfile(stdout);
+	} else if (g->offline) {
+		// Keep the lines of tuners printing at the same time apart.
+		flockfile(stdout);
+		for (uint c = 0; c < g->nchannels; ++c) {
+			ch = &g->channels[c];
+			print_track(g, t_end, c, note_valid(g, ch->note_freq) ? ch->note : NULL,
+				    ch->note_freq, ch->cents);
+		}
+		funlockfile(stdout);
+	} else {
+		publish_notes(g);
+	}
+	hist_add(&s->stages[STATS_OUTPUT], stats_ns_since(&t));
+
+	// The first note has no hop before it.
+	if (s->stages[STATS_OUTPUT].count > 1)
+		hist_add(&s->stages[STATS_HOP], stats_ns_since(&g->last_output));
+	g->last_output = t;
+
+	requests = atomic_load_explicit(&stats_requests, memory_order_relaxed);
+	if (requests != g->stats_seen) {
+		g->stats_seen = requests;
+		snapshot_stats(g, requests);
+	}
+}
+
+/*
+ * gtune_read_chunk - Read a whole chunk of samples into each channel's samples array
+ *
+ * The chunk is read again if samples were lost in capture while reading it, since there
+ * would be a gap in the middle of the chunk. Return false if the source has come to an end.
+ */
+static bool gtune_read_chunk(gtune_t *g)
 {
 	for (;;) {
-		mic_read_until_success(&g->mic, g->samples, g->chunksz);
-		gtune_freq(g, g->samples);
+		if (!gtune_read(g, 0, g->chunksz))
+			return false;
+		if (!source_discontinuity(&g->src))
+			return true;
+		++g->stats.retries;
 	}
 }
 
+static bool gtune_stopping(gtune_t *g)
+{
+	return atomic_load_explicit(&g->stopping, memory_order_relaxed);
+}
+
+/*
+ * gtune - Process samples without a step
+ */
+static void gtune(gtune_t *g)
+{
+	while (!gtune_stopping(g) && gtune_read_chunk(g))
+		gtune_freq(g);
+}
+
+/*
+ * gtune_read_step - Read a step of samples into the channels' circular buffers of samples
+ * @head: index in the circular buffers to read the step into
+ *
+ * A step that runs past the end of the buffer wraps around to its start. This only happens
+ * when the chunk size isn't a multiple of the step size. Return false if the source has come
+ * to an end.
+ */
+static bool gtune_read_step(gtune_t *g, uint head)
+{
+	uint n = g->chunksz-head;
+
+	if (n >= g->chunk_stepsz)
+		return gtune_read(g, head, g->chunk_stepsz);
+	return gtune_read(g, head, n) && gtune_read(g, 0, g->chunk_stepsz-n);
+}
+
 /*
  * gtune_step - Process samples with the step provided by the user 
  *
- * This implementation does a bunch of copying, which is fine since it's O(n) and 
- * processing of the data is O(n*logn) by FFT's supposed complexity, but it could be avoided
- * entirely by implementing a circular buffer FFT operation.
+ * Each channel's samples array is a circular buffer holding the latest chunk of its samples,
+ * all with the same head. A newly read step overwrites the oldest step in place, so no samples are copied around between steps,
+ * and the normalise stage of processing unrolls the two wrapped segments of the buffer
+ * straight into the FFT input. The cost of a step is then the same however many steps there are.
  *
  * Example: in the below ____ denotes the samples array and | identifies an index start of a step in the samples array. 
- * Here nstep=4, so the samples array is broken up into 4 sections (0-indexed).
+ * Here nstep=4, so the samples array is broken up into 4 sections (0-indexed). The head is the index
+ * of the oldest sample, which is where the next step is read into.
  *
- * 1. The samples array is filled completely.
+ * 1. The samples array is filled completely. The head is at index 0.
  *
- *                      * samples+bytes_in_chunk_step     * samples+bytes_to_chunk_last_step
+ *     * head
  *     0                1                2                3
  *     |________________|________________|________________|________________
  *
- * 2. The whole samples array is processed for a frequency.
- * 3. Samples are copied from range index 1 (inclusive) to the end of the array, to range index 0 (inclusive)
- * to index 3 (exclusive). Characters other than _ are used to show whether step sections have the same samples.
+ * 2. The whole samples array is processed for a frequency, starting from the head (oldest) and
+ * wrapping around to end just before the head (newest).
+ * 3. Read new samples into the step at the head, overwriting the oldest samples. Characters nnnn
+ * denote newly read in samples. The head moves on a step, to the now oldest samples.
  *
- *                               * copy from range---------------------------------*
- *		* copy to range ----------------------------------*       
- *              0                1                2                3
- * before copy: |________________|xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO
- * after copy:  |xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO|OOOOOOOOOOOOOOOO
- *								   
- * Notice that after copying, section at index 0 lost its ____ samples, and sections 
- * at indices 2 and 3 now share the same OOOO samples. 
- *					   
- * 4. Read new samples starting at index 3, overwriting now redundant samples. Characters nnnn 
- * denote newly read in samples.
+ *                      * head
+ * before read: |________________|xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO
+ * after read:  |nnnnnnnnnnnnnnnn|xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO
  *
- *                                                                 * read into here
- * before read: |xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO|OOOOOOOOOOOOOOOO
- * after read:  |xxxxxxxxxxxxxxxx|oooooooooooooooo|OOOOOOOOOOOOOOOO|nnnnnnnnnnnnnnnn
+ * The next process is of the samples in order xxxx, oooo, OOOO, nnnn.
  *
- * 5. A "step" has been done. Jump to 2. to process the frequency and step again (loop).
+ * 4. A "step" has been done. Jump to 2. to process the frequency and step again (loop).
  */
 static void gtune_step(gtune_t *g)
 {
-	uint chunk_last_step_index;
-	off_t bytes_to_chunk_last_step, bytes_in_chunk_step;
-
-	chunk_last_step_index = (g->chunk_nsteps-1)*g->chunk_stepsz;
-	// Convert from number of samples to a byte offset.
-	bytes_to_chunk_last_step = chunk_last_step_index*g->meta->samplesz;
-	bytes_in_chunk_step = g->chunk_stepsz*g->meta->samplesz;
-
 	// Read a whole chunk.
-	mic_read_until_success(&g->mic, g->samples, g->chunksz);
-	for (;;) {
-		gtune_freq(g, g->samples);
-		// Use memmove() over memcpy() because source and dest arrays overlap.
-		memmove(g->samples, g->samples+bytes_in_chunk_step, bytes_to_chunk_last_step);
+	g->head = 0;
+	if (!gtune_read_chunk(g))
+		return;
+	while (!gtune_stopping(g)) {
+		gtune_freq(g);
 		// Read a step of a chunk (will block for chunksz/number of chunk steps amount of time).
-		mic_read_until_success(&g->mic, g->samples+bytes_to_chunk_last_step, g->chunk_stepsz);
+		if (!gtune_read_step(g, g->head))
+			return;
+		g->head = (g->head+g->chunk_stepsz)%g->chunksz;
+		// Samples lost in capture leave a gap between the new step and the rest of the
+		// chunk, so start over with a whole new chunk rather than process a corrupted one.
+		if (source_discontinuity(&g->src)) {
+			++g->stats.retries;
+			if (!gtune_read_chunk(g))
+				return;
+			g->head = 0;
+			for (uint c = 0; c < g->nchannels; ++c)
+				fdata_reset(&g->channels[c].freq);
+		}
 	}
 }
 
-void gtune_start(gtune_t *g)
+/*
+ * gtune_run - Process samples of a started tuner until its source comes to an end or it's stopped
+ */
+static void gtune_run(gtune_t *g)
 {
-	print_header();
 	if (no_stepping(g->chunk_nsteps))
 		gtune(g);
 	else
 		gtune_step(g);
 }
 
+bool gtune_start(gtune_t *g)
+{
+	if (!source_start(&g->src))
+		return false;
+	clock_gettime(CLOCK_MONOTONIC, &g->start);
+
+	if (!displaying(g)) {
+		if (g->output == STREAM_NONE)
+			print_track_header(g);
+		gtune_run(g);
+		fflush(stdout);
+		return true;
+	}
+	print_header(g);
+	if (!render_start(&g->render))
+		return false;
+	gtune_run(g);
+	render_stop(&g->render);
+	if (!g->label)
+		printf("\n");
+	return true;
+}
+
+static void *gtune_thread(void *data)
+{
+	gtune_run(data);
+	return NULL;
+}
+
+bool gtune_start_all(gtune_t *tuners, uint n)
+{
+	pthread_t *threads;
+	uint nthreads, nrenders = 0;
+	bool success = false;
+	int err;
+
+	if (n == 1)
+		return gtune_start(tuners);
+	if (!(threads = malloc(n*sizeof(pthread_t)))) {
+		eprintf("failed to allocate tuner threads: %s", strerror(errno));
+		return false;
+	}
+	for (uint i = 0; i < n; ++i) {
+		if (!source_start(&tuners[i].src))
+			goto gtune_start_all_error;
+	}
+	if (displaying(tuners))
+		print_header(tuners);
+	else if (tuners->output == STREAM_NONE)
+		print_track_header(tuners);
+	fflush(stdout);
+	for (nrenders = 0; displaying(tuners) && nrenders < n; ++nrenders) {
+		if (!render_start(&tuners[nrenders].render))
+			goto gtune_start_all_error;
+	}
+
+	for (nthreads = 0; nthreads < n; ++nthreads) {
+		clock_gettime(CLOCK_MONOTONIC, &tuners[nthreads].start);
+		if ((err = pthread_create(&threads[nthreads], NULL, gtune_thread, &tuners[nthreads])) != 0) {
+			eprintf("failed to start tuner thread: %s", strerror(err));
+			for (uint i = 0; i < nthreads; ++i)
+				gtune_stop(&tuners[i]);
+			break;
+		}
+	}
+	success = nthreads == n;
+	for (uint i = 0; i < nthreads; ++i)
+		pthread_join(threads[i], NULL);
+
+gtune_start_all_error:
+	for (uint i = 0; i < nrenders; ++i)
+		render_stop(&tuners[i].render);
+	fflush(stdout);
+	free(threads);
+	return success;
+}
+
+void gtune_stop(gtune_t *g)
+{
+	atomic_store_explicit(&g->stopping, true, memory_order_relaxed);
+}
@@ -12,45 +12,140 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "note.h"
 #include "freq.h"
-#include "mic.h"
+#include "source.h"
 #include "math.h"
+#include "stats.h"
+#include "pool.h"
+#include "render.h"
+#include "stream.h"
+#include "pub.h"
+#include "tribuf.h"
+
+/*
+ * Parameters for initialising a guitar tuner.
+ * @src: where audio input comes from, and how many channels of it to track the pitch of
+ * @chunksz: number of samples to both read and process per frequency calculation
+ * @chunk_nsteps: a number >= 1 that determines the step size between frequency processes. 2 steps means
+ *	that the whole of a chunk will be passed in 2 steps. A chunk size of 8192 and chunk steps of 2 gives
+ *	a chunk step size of 8192/2 = 4096. This step size of half the chunk size will, on reading a chunk, first
+ *	have the whole chunk processed, then on the next process will be the second half of the just
+ *	processed chunk and the first half of the next read chunk, and again on the next next process will be
+ *	the whole of the next chunk. This is to allow for a faster refresh rate, since, for example with
+ *	a step of 2 there will be 2 prints per chunk process, using overlapping parts of the chunks.
+ * @min_valid_freq: minimum valid frequency (inclusive) that is considered a note. 
+ * @max_valid_freq: maximum valid frequency (inclusive) that is considered a note
+ * @freq: parameters of processing samples into frequencies
+ * @offline: print a timestamped pitch track, one line per processed chunk, instead of the
+ *	live display, and read sources that aren't realtime as fast as possible
+ * @kernels: name of the processing kernels to use (see kern.h), or NULL for the fastest
+ *	the CPU supports
+ * @stats_path: file to write a snapshot of statistics to when asked for one with SIGUSR1,
+ *	or NULL to print it to stderr
+ * @label: name printed with the tuner's notes and statistics to tell them apart from those of
+ *	other tuners run at the same time with gtune_start_all(), or NULL if it's the only tuner
+ * @fps: most times a second the live display is redrawn, which it only is when the notes change,
+ *	or the stream of records is flushed when it's live
+ * @output: format of a stream of records to write instead of the display or pitch track
+ * @index: index of the tuner among those started together, for telling their binary records apart
+ * @pub_path: file to publish the latest pitch of each hop in for other processes to read
+ *	(see pub.h), or NULL for none
+ */
+struct gtune_params {
+	struct source_params src;
+	uint chunksz;
+	uint chunk_nsteps;
+	double min_valid_freq;
+	double max_valid_freq;
+	struct fdata_params freq;
+	bool offline;
+	const char *kernels;
+	const char *stats_path;
+	const char *label;
+	uint fps;
+	stream_format output;
+	uint index;
+	const char *pub_path;
+};
+
+// A channel of the tuner's input, such as a string of a hexaphonic pickup, whose pitch is
+// tracked separately from the other channels'.
+struct gtune_channel {
+	fdata_t freq;  // For converting the channel's samples into frequencies.
+	char *samples;  // Array to store the channel's read samples in. The size of a sample is described in meta.
+	char note[MAX_NOTE_LEN];  // Last valid frequency converted to a musical note.
+	double cents;  // Cents the last valid frequency is sharp or flat of the note.
+	double note_freq;  // Frequency of the last processed chunk.
+	struct note cur;  // Note of the last processed chunk, with an index of -1 if it isn't valid.
+	uint64_t stage_ns[FDATA_NSTAGES];  // Times of the stages of processing the last chunk.
+};
+
+// A snapshot of a tuner's statistics, copied by its processing thread for the signal thread
+// to print.
+struct stats_snapshot {
+	stats_t stats;
+	unsigned long overruns;
+	unsigned long overflows;
+};
 
 // All the data required by the guitar tuner.
-// See gtune_init() for info on struct members.
+// See gtune_params for info on struct members.
 struct guitar_tuner {
-	fdata_t freq;  // For converting audio input into frequencies.
-	mic_t mic;  // For audio input.
-	char note[MAX_NOTE_LEN];  // Frequency converted to a musical note.
+	source_t src;  // For audio input.
+	struct gtune_channel *channels;
+	uint nchannels;
+	char *frames;  // Interleaved frames read from a multi-channel source, before they're split into channels.
+	pool_t pool;  // Workers that process the channels in parallel.
+	render_t render;  // Live display of the channels' notes, not used offline or when streaming.
+	uint head;  // Index of the oldest sample in the channels' circular buffers of samples.
 	sdtype_meta_t *meta;  // Metadata describing the data type of the samples for normalising them.
 	PaSampleFormat pafmt;
-	char *samples;  // Array to store read samples in. The size of a sample is described in meta.
 	double min_valid_freq;
 	double max_valid_freq;
+	note_table_t notes;  // Notes of the valid frequencies, for converting frequencies into notes.
 	uint chunksz;
 	uint chunk_nsteps;
 	uint chunk_stepsz;
+	bool offline;
+	uint64_t nread;  // Number of samples read from the source so far.
+	struct timespec start;  // Time the source was started, for pacing sources that aren't realtime.
+	stats_t stats;
+	struct timespec last_output;  // Time the last note was printed.
+	struct timespec last_read;  // Wall clock time the last samples were read, for records.
+	struct timespec last_flush;  // Time the stream of records was last flushed.
+	long flush_ns;  // Least time between flushes of a live stream of records.
+	stream_format output;
+	uint index;
+	pub_t pub;  // Publication of the latest pitch, whose page is NULL if there's none.
+	uint64_t hops;  // Number of hops processed.
+	const char *stats_path;
+	uint stats_seen;  // Number of requests for statistics already answered. See stats_requests.
+	tribuf_t stats_snaps;  // Snapshots of statistics, the latest taken by gtune_print_stats().
+	atomic_uint stats_answered;  // Number of requests answered as of the latest snapshot.
+	const char *label;
+	atomic_bool stopping;  // Set by gtune_stop() to stop the tuner after its current hop.
 };
 
 typedef struct guitar_tuner gtune_t;
 
+/*
+ * gtune_params_default - Set parameters to their defaults, recording from the
+ *	default microphone
+ */
+void gtune_params_default(struct gtune_params *p);
+
 /*
  * gtune_init - Initialise guitar tuner data
- * @sample_rate: number of samples recorded per second (Hz)
- * @chunksz: number of samples to both read and process per frequency calculation
- * @chunk_nsteps: a number >= 1 that determines the step size between frequency processes. 2 steps means
- *	that the whole of a chunk will be passed in 2 steps. A chunk size of 8192 and chunk steps of 2 gives
- *	a chunk step size of 8192/2 = 4096. This step size of half the chunk size will, on reading a chunk, first
- *	have the whole chunk processed, then on the next process will be the second half of the just
- *	processed chunk and the first half of the next read chunk, and again on the next next process will be
- *	the whole of the next chunk. This is to allow for a faster refresh rate, since, for example with
- *	a step of 2 there will be 2 prints per chunk process, using overlapping parts of the chunks.
- * @min_valid_freq: minimum valid frequency (inclusive) that is considered a note. 
- * @max_valid_freq: maximum valid frequency (inclusive) that is considered a note
- * @fmt: pulse audio data type and size/format of a sample
+ * @p: parameters of the tuner. See struct gtune_params
  *
- * The accuracy of a reading is calculated by sample_rate/chunksz. This means that for a sample rate of
+ * Without interpolation (see fdata_interp), the accuracy of a reading is calculated by sample_rate/chunksz.
+ * This means that for a sample rate of
  * 44100 Hz and chunk size of 8192, the accuracy is 44100/8192 ~= 5.38, which has that while tuning up from
  * 110 Hz, for example, a next higher Hz will only appear when tuned up to 110+5.38 = 115.38 Hz.
  * Again, for a sample rate of 8000 and chunk size of 8192, the accuracy is 8000/8192 ~= 0.98, so
@@ -62,10 +157,14 @@ typedef struct guitar_tuner gtune_t;
  * 1.02 seconds. This can be "offset" by making chunk_nsteps greater than 1 - making it 2 with an initial
  * refresh rate of 1.02 seconds will have it refresh at 1.02/2 = 0.51 seconds.
  *
+ * Interpolating the peak between bins (the default) gets within a fraction of a Hz at a chunk size of
+ * 4096 at 44100 Hz, so small chunk sizes no longer cost accuracy. They still cost resolution of low notes
+ * that are close together, since the harmonic product spectrum needs their bins apart. The McLeod pitch
+ * method (see fdata_estimator_mpm) doesn't, and only needs chunks of about 2 periods of the lowest note.
+ *
  * Return whether initialisation was successful.
  */
-bool gtune_init(gtune_t *g, uint sample_rate, uint chunksz, uint chunk_nsteps, 
-		double min_valid_freq, double max_valid_freq, PaSampleFormat fmt);
+bool gtune_init(gtune_t *g, struct gtune_params *p);
 
 /*
  * Clean up and free a guiter tuner allocated with gtune_init().
@@ -74,7 +173,44 @@ void gtune_cleanup(gtune_t *g);
 
 /*
  * gtune_start - Start recording and displaying frequencies and notes
+ *
+ * The notes of every channel are displayed together by a thread of their own, redrawn when a
+ * processed chunk changes them up to fps times a second, so that a slow terminal never holds up
+ * processing. In offline mode the pitch track is printed as each chunk is processed instead,
+ * and with an output format a record is written per channel of each chunk instead of either.
+ * Live records are flushed up to fps times a second, and offline ones when the buffer is full.
+ * Only returns once the source comes to an end, which the microphone never does, or the
+ * tuner is stopped with gtune_stop(). Return false if the source couldn't be started.
+ */
+bool gtune_start(gtune_t *g);
+
+/*
+ * gtune_start_all - Start tuners each on a thread of their own and display their notes
+ * @tuners: tuners to start, each with a label if there's more than one
+ * @n: number of tuners
+ *
+ * The tuners share the portaudio session and FFTW's plans, but each has its own capture and
+ * processing so that they run independently of each other. Only returns once all the tuners'
+ * sources come to an end or they're stopped. Return false if a source couldn't be started.
+ */
+bool gtune_start_all(gtune_t *tuners, uint n);
+
+/*
+ * gtune_stop - Ask a started tuner to stop once it has finished the hop it's on
+ *
+ * Can be called from any thread.
+ */
+void gtune_stop(gtune_t *g);
+
+/*
+ * gtune_print_stats - Print a snapshot of the tuner's latency histograms and lost sample
+ *	counts, to the stats file if one was given, otherwise stderr
+ *
+ * Called by the signal thread when SIGUSR1 asks for it, after stats_requests was bumped. The
+ * tuner only copies its statistics into a snapshot between chunks, which this waits for, so
+ * that writing them never holds up processing. Gives up on a tuner that doesn't answer within
+ * a second, such as one whose source has come to an end.
  */
-void gtune_start(gtune_t *g);
+void gtune_print_stats(gtune_t *g);
 
 #endif
@@ -0,0 +1,91 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * NEON kernels for 64-bit ARM. NEON is part of the base AArch64 instruction set, but check
+ * the hardware capabilities anyway to keep to the pattern of the other variants.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifdef __aarch64__
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include "kern.h"
+
+#define KERN(fn) neon_##fn
+#define KERN_FN static
+#define KERN_TABLE kern_neon
+#define KERN_NAME "neon"
+
+#ifdef GTUNE_FLOAT
+#define VEC float32x4_t
+#define VW 4
+#define VLOADU(p) vld1q_f32(p)
+#define VSTOREU(p, v) vst1q_f32(p, v)
+#define VMUL(a, b) vmulq_f32(a, b)
+#define VADD(a, b) vaddq_f32(a, b)
+#define VSQRT(a) vsqrtq_f32(a)
+#define VMAX(a, b) vmaxq_f32(a, b)
+#define VCVT_F32(p) vld1q_f32(p)
+#define VCVT_S16(p) vcvtq_f32_s32(vmovl_s16(vld1_s16(p)))
+#define VCVT_S32(p) vcvtq_f32_s32(vld1q_s32(p))
+
+KERN_FN float32x4_t KERN(sumsq_pairs)(const real_t *p)
+{
+	// De-interleave the real and imaginary parts.
+	float32x4x2_t c = vld2q_f32(p);
+
+	return vaddq_f32(vmulq_f32(c.val[0], c.val[0]), vmulq_f32(c.val[1], c.val[1]));
+}
+
+KERN_FN float32x4_t KERN(gather)(const real_t *a, int i, int ds)
+{
+	float lanes[4] = { a[i*ds], a[(i+1)*ds], a[(i+2)*ds], a[(i+3)*ds] };
+
+	return vld1q_f32(lanes);
+}
+#else
+#define VEC float64x2_t
+#define VW 2
+#define VLOADU(p) vld1q_f64(p)
+#define VSTOREU(p, v) vst1q_f64(p, v)
+#define VMUL(a, b) vmulq_f64(a, b)
+#define VADD(a, b) vaddq_f64(a, b)
+#define VSQRT(a) vsqrtq_f64(a)
+#define VMAX(a, b) vmaxq_f64(a, b)
+#define VCVT_F32(p) vcvt_f64_f32(vld1_f32(p))
+#define VCVT_S16(p) KERN(load_s16)(p)
+#define VCVT_S32(p) vcvtq_f64_s64(vmovl_s32(vld1_s32(p)))
+
+// Too few int16s for a 64-bit register to be worth widening.
+KERN_FN float64x2_t KERN(load_s16)(const int16_t *p)
+{
+	return (float64x2_t){ p[0], p[1] };
+}
+
+KERN_FN float64x2_t KERN(sumsq_pairs)(const real_t *p)
+{
+	float64x2x2_t c = vld2q_f64(p);
+
+	return vaddq_f64(vmulq_f64(c.val[0], c.val[0]), vmulq_f64(c.val[1], c.val[1]));
+}
+
+KERN_FN float64x2_t KERN(gather)(const real_t *a, int i, int ds)
+{
+	double lanes[2] = { a[i*ds], a[(i+1)*ds] };
+
+	return vld1q_f64(lanes);
+}
+#endif
+
+static bool KERN(supported)(void)
+{
+	return getauxval(AT_HWCAP) & HWCAP_ASIMD;
+}
+
+#define VEND()
+
+#include "kern-simd.h"
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Template of the SIMD kernels, written once over a handful of vector operation macros
+ * and included once per instruction set with the macros defined for that instruction set
+ * and the precision of real_t. The including file must define:
+ *
+ * KERN(fn)      name of a kernel function of the instruction set
+ * KERN_FN       attributes of a kernel function, such as its target instruction set
+ * KERN_TABLE    name of the kern_t of the instruction set
+ * KERN_NAME     name of the instruction set
+ * VEC           vector type of reals, VW reals wide
+ * VLOADU(p), VSTOREU(p, v), VADD(a, b), VMUL(a, b), VSQRT(a), VMAX(a, b)
+ *               unaligned load and store, and element-wise operations
+ * VCVT_F32(p), VCVT_S16(p), VCVT_S32(p)
+ *               load VW floats, int16s or int32s and convert them to a vector of reals
+ * KERN(sumsq_pairs)(p)
+ *               function of the squared magnitudes of the VW complex numbers at p
+ * KERN(gather)(a, i, ds)
+ *               function loading a[i*ds], a[(i+1)*ds], ..., a[(i+VW-1)*ds]
+ * KERN(supported)()
+ *               function of whether the CPU supports the instruction set
+ * VEND()        clean up after the vector instructions, before any scalar code, such as
+ *               clearing the upper halves of AVX registers. Compilers only do this
+ *               themselves when optimising, and without it every SSE instruction run
+ *               afterwards, in FFTW and the rest of the program, is slowed down
+ *
+ * Each kernel does as much as it can with vectors, then finishes the remaining
+ * elements one at a time.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+
+#define KERN_CONVERT(name, type, vcvt) \
+KERN_FN void KERN(name)(const type *in, const real_t *w, real_t *out, uint n) \
+{ \
+	uint i = 0; \
+\
+	if (w) { \
+		for (; i+VW <= n; i += VW) \
+			VSTOREU(out+i, VMUL(vcvt(in+i), VLOADU(w+i))); \
+		VEND(); \
+		for (; i < n; ++i) \
+			out[i] = (real_t)in[i]*w[i]; \
+	} else { \
+		for (; i+VW <= n; i += VW) \
+			VSTOREU(out+i, vcvt(in+i)); \
+		VEND(); \
+		for (; i < n; ++i) \
+			out[i] = in[i]; \
+	} \
+}
+
+KERN_CONVERT(convert_f32, float, VCVT_F32)
+KERN_CONVERT(convert_s16, int16_t, VCVT_S16)
+KERN_CONVERT(convert_s32, int32_t, VCVT_S32)
+
+KERN_FN void KERN(window)(real_t *restrict a, const real_t *restrict w, int n)
+{
+	int i = 0;
+
+	for (; i+VW <= n; i += VW)
+		VSTOREU(a+i, VMUL(VLOADU(a+i), VLOADU(w+i)));
+	VEND();
+	for (; i < n; ++i)
+		a[i] *= w[i];
+}
+
+KERN_FN void KERN(decimate)(const real_t *in, const real_t *taps, uint ntaps, uint factor,
+			    const real_t *w, real_t *out, uint n)
+{
+	real_t lanes[VW];
+	real_t sum;
+	uint k;
+	VEC acc;
+
+	for (uint i = 0; i < n; ++i, in += factor) {
+		sum = 0;
+		k = 0;
+		if (ntaps >= VW) {
+			acc = VMUL(VLOADU(in), VLOADU(taps));
+			for (k = VW; k+VW <= ntaps; k += VW)
+				acc = VADD(acc, VMUL(VLOADU(in+k), VLOADU(taps+k)));
+			VSTOREU(lanes, acc);
+			for (int j = 0; j < VW; ++j)
+				sum += lanes[j];
+		}
+		for (; k < ntaps; ++k)
+			sum += in[k]*taps[k];
+		out[i] = sum*w[i];
+	}
+	VEND();
+}
+
+// See HPS_POWER().
+#ifdef GTUNE_FLOAT
+#define VPOWER(v) VSQRT(v)
+#else
+#define VPOWER(v) (v)
+#endif
+
+// Squared magnitudes of the complex numbers at c[i*ds], c[(i+1)*ds], ..., c[(i+VW-1)*ds].
+KERN_FN VEC KERN(gather_sumsq)(fft_complex *c, int i, int ds)
+{
+	VEC re = KERN(gather)((real_t *)c, i, 2*ds);
+	VEC im = KERN(gather)((real_t *)c+1, i, 2*ds);
+
+	return VADD(VMUL(re, re), VMUL(im, im));
+}
+
+KERN_FN uint KERN(hps_argmax)(fft_complex *c, uint lo, uint hi, uint len, uint n)
+{
+	real_t blk[HPS_BLOCKSZ];
+	real_t lanes[VW];
+	real_t first = hps_product(c, lo, len, n);
+	real_t max = first, bmax;
+	// Bins below this have every harmonic multiplied in, so can be done a vector at a time.
+	uint whole = len/n;
+	uint maxi = lo, nb, nv, i;
+	VEC p, m;
+
+	for (uint b = lo; b <= hi; b += nb) {
+		nb = hi+1-b < HPS_BLOCKSZ ? hi+1-b : HPS_BLOCKSZ;
+		nv = whole <= b ? 0 : whole-b < nb ? whole-b : nb;
+		// Products are never negative.
+		bmax = -1;
+		i = 0;
+		if (nv >= VW) {
+			// Each harmonic is read straight from the FFT's output, and the products
+			// of the block stay in cache for finding the max among them.
+			for (; i+VW <= nv; i += VW) {
+				p = VPOWER(KERN(sumsq_pairs)((real_t *)(c+b+i)));
+				for (uint ds = 2; ds <= n; ++ds)
+					p = VMUL(p, VPOWER(KERN(gather_sumsq)(c, b+i, ds)));
+				VSTOREU(blk+i, p);
+				m = i == 0 ? p : VMAX(m, p);
+			}
+			VSTOREU(lanes, m);
+			VEND();
+			for (int j = 0; j < VW; ++j) {
+				if (lanes[j] > bmax)
+					bmax = lanes[j];
+			}
+		}
+		for (; i < nb; ++i) {
+			blk[i] = hps_product(c, b+i, len, n);
+			if (blk[i] > bmax)
+				bmax = blk[i];
+		}
+		// Ties go to the highest bin, so a block whose max equals the one so far has it.
+		if (bmax < max)
+			continue;
+		max = bmax;
+		for (i = nb; i-- > 0 && blk[i] != max;)
+			;
+		maxi = b+i;
+	}
+	// Break ties the same way as maxi_real().
+	return first == max ? lo : maxi;
+}
+
+const kern_t KERN_TABLE = {
+	KERN_NAME,
+	KERN(supported),
+	KERN(convert_f32),
+	KERN(convert_s16),
+	KERN(convert_s32),
+	KERN(window),
+	KERN(decimate),
+	KERN(hps_argmax)
+};
+
+#undef KERN_CONVERT
+#undef KERN
+#undef KERN_FN
+#undef KERN_TABLE
+#undef KERN_NAME
+#undef VEC
+#undef VW
+#undef VLOADU
+#undef VSTOREU
+#undef VADD
+#undef VMUL
+#undef VSQRT
+#undef VMAX
+#undef VPOWER
+#undef VCVT_F32
+#undef VCVT_S16
+#undef VCVT_S32
+#undef VEND
@@ -0,0 +1,282 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * SSE2, AVX2 and AVX-512 kernels for x86, each compiled for its instruction set with a
+ * target attribute so that the rest of the program doesn't need to be, and only used
+ * when the CPU running the program supports it.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include "kern.h"
+
+/*
+ * SSE2
+ */
+#define KERN(fn) sse2_##fn
+#define KERN_FN static __attribute__((target("sse2")))
+#define KERN_TABLE kern_sse2
+#define KERN_NAME "sse2"
+
+#ifdef GTUNE_FLOAT
+#define VEC __m128
+#define VW 4
+#define VLOADU(p) _mm_loadu_ps(p)
+#define VSTOREU(p, v) _mm_storeu_ps(p, v)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSQRT(a) _mm_sqrt_ps(a)
+#define VMAX(a, b) _mm_max_ps(a, b)
+#define VCVT_F32(p) _mm_loadu_ps(p)
+#define VCVT_S16(p) _mm_cvtepi32_ps(KERN(load_s16)(p))
+#define VCVT_S32(p) _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(p)))
+
+// Sign extend 4 int16s to int32s.
+KERN_FN __m128i KERN(load_s16)(const int16_t *p)
+{
+	__m128i v = _mm_loadl_epi64((const __m128i *)p);
+
+	return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+KERN_FN __m128 KERN(sumsq_pairs)(const real_t *p)
+{
+	__m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p+4);
+
+	a = _mm_mul_ps(a, a);
+	b = _mm_mul_ps(b, b);
+	return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+			  _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// SSE2 has no gather.
+KERN_FN __m128 KERN(gather)(const real_t *a, int i, int ds)
+{
+	return _mm_setr_ps(a[i*ds], a[(i+1)*ds], a[(i+2)*ds], a[(i+3)*ds]);
+}
+#else
+#define VEC __m128d
+#define VW 2
+#define VLOADU(p) _mm_loadu_pd(p)
+#define VSTOREU(p, v) _mm_storeu_pd(p, v)
+#define VMUL(a, b) _mm_mul_pd(a, b)
+#define VADD(a, b) _mm_add_pd(a, b)
+#define VSQRT(a) _mm_sqrt_pd(a)
+#define VMAX(a, b) _mm_max_pd(a, b)
+#define VCVT_F32(p) _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)(p))))
+#define VCVT_S16(p) _mm_cvtepi32_pd(KERN(load_s16)(p))
+#define VCVT_S32(p) _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(p)))
+
+// Sign extend 2 int16s to int32s.
+KERN_FN __m128i KERN(load_s16)(const int16_t *p)
+{
+	int32_t pair;
+	__m128i v;
+
+	memcpy(&pair, p, sizeof(pair));
+	v = _mm_cvtsi32_si128(pair);
+	return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+
+KERN_FN __m128d KERN(sumsq_pairs)(const real_t *p)
+{
+	__m128d a = _mm_loadu_pd(p), b = _mm_loadu_pd(p+2);
+
+	a = _mm_mul_pd(a, a);
+	b = _mm_mul_pd(b, b);
+	return _mm_add_pd(_mm_unpacklo_pd(a, b), _mm_unpackhi_pd(a, b));
+}
+
+KERN_FN __m128d KERN(gather)(const real_t *a, int i, int ds)
+{
+	return _mm_setr_pd(a[i*ds], a[(i+1)*ds]);
+}
+#endif
+
+static bool KERN(supported)(void)
+{
+	return __builtin_cpu_supports("sse2");
+}
+
+#define VEND()
+
+#include "kern-simd.h"
+
+/*
+ * AVX2
+ */
+#define KERN(fn) avx2_##fn
+#define KERN_FN static __attribute__((target("avx2")))
+#define KERN_TABLE kern_avx2
+#define KERN_NAME "avx2"
+
+#ifdef GTUNE_FLOAT
+#define VEC __m256
+#define VW 8
+#define VLOADU(p) _mm256_loadu_ps(p)
+#define VSTOREU(p, v) _mm256_storeu_ps(p, v)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSQRT(a) _mm256_sqrt_ps(a)
+#define VMAX(a, b) _mm256_max_ps(a, b)
+#define VCVT_F32(p) _mm256_loadu_ps(p)
+#define VCVT_S16(p) _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32( \
+		_mm_loadu_si128((const __m128i *)(p))))
+#define VCVT_S32(p) _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(p)))
+
+KERN_FN __m256 KERN(sumsq_pairs)(const real_t *p)
+{
+	__m256 a = _mm256_loadu_ps(p), b = _mm256_loadu_ps(p+8);
+	__m256 s;
+
+	a = _mm256_mul_ps(a, a);
+	b = _mm256_mul_ps(b, b);
+	// Sums of pairs in the order 0 1 4 5 2 3 6 7, so swap the middle 64 bits of them.
+	s = _mm256_hadd_ps(a, b);
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(s),
+						      _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+KERN_FN __m256 KERN(gather)(const real_t *a, int i, int ds)
+{
+	__m256i idx = _mm256_mullo_epi32(
+		_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+		_mm256_set1_epi32(ds));
+
+	return _mm256_i32gather_ps(a, idx, sizeof(real_t));
+}
+#else
+#define VEC __m256d
+#define VW 4
+#define VLOADU(p) _mm256_loadu_pd(p)
+#define VSTOREU(p, v) _mm256_storeu_pd(p, v)
+#define VMUL(a, b) _mm256_mul_pd(a, b)
+#define VADD(a, b) _mm256_add_pd(a, b)
+#define VSQRT(a) _mm256_sqrt_pd(a)
+#define VMAX(a, b) _mm256_max_pd(a, b)
+#define VCVT_F32(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define VCVT_S16(p) _mm256_cvtepi32_pd(_mm_cvtepi16_epi32( \
+		_mm_loadl_epi64((const __m128i *)(p))))
+#define VCVT_S32(p) _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(p)))
+
+KERN_FN __m256d KERN(sumsq_pairs)(const real_t *p)
+{
+	__m256d a = _mm256_loadu_pd(p), b = _mm256_loadu_pd(p+4);
+
+	a = _mm256_mul_pd(a, a);
+	b = _mm256_mul_pd(b, b);
+	// Sums of pairs in the order 0 2 1 3.
+	return _mm256_permute4x64_pd(_mm256_hadd_pd(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+KERN_FN __m256d KERN(gather)(const real_t *a, int i, int ds)
+{
+	__m128i idx = _mm_mullo_epi32(
+		_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3)),
+		_mm_set1_epi32(ds));
+
+	return _mm256_i32gather_pd(a, idx, sizeof(real_t));
+}
+#endif
+
+static bool KERN(supported)(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+#define VEND() _mm256_zeroupper()
+
+#include "kern-simd.h"
+
+/*
+ * AVX-512, only the foundation instructions.
+ */
+#define KERN(fn) avx512_##fn
+#define KERN_FN static __attribute__((target("avx512f")))
+#define KERN_TABLE kern_avx512
+#define KERN_NAME "avx512"
+
+#ifdef GTUNE_FLOAT
+#define VEC __m512
+#define VW 16
+#define VLOADU(p) _mm512_loadu_ps(p)
+#define VSTOREU(p, v) _mm512_storeu_ps(p, v)
+#define VMUL(a, b) _mm512_mul_ps(a, b)
+#define VADD(a, b) _mm512_add_ps(a, b)
+#define VSQRT(a) _mm512_sqrt_ps(a)
+#define VMAX(a, b) _mm512_max_ps(a, b)
+#define VCVT_F32(p) _mm512_loadu_ps(p)
+#define VCVT_S16(p) _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32( \
+		_mm256_loadu_si256((const __m256i *)(p))))
+#define VCVT_S32(p) _mm512_cvtepi32_ps(_mm512_loadu_si512(p))
+
+KERN_FN __m512 KERN(sumsq_pairs)(const real_t *p)
+{
+	const __m512i re = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14,
+					     16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i im = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15,
+					     17, 19, 21, 23, 25, 27, 29, 31);
+	__m512 a = _mm512_loadu_ps(p), b = _mm512_loadu_ps(p+16);
+
+	a = _mm512_mul_ps(a, a);
+	b = _mm512_mul_ps(b, b);
+	return _mm512_add_ps(_mm512_permutex2var_ps(a, re, b), _mm512_permutex2var_ps(a, im, b));
+}
+
+KERN_FN __m512 KERN(gather)(const real_t *a, int i, int ds)
+{
+	__m512i idx = _mm512_mullo_epi32(
+		_mm512_add_epi32(_mm512_set1_epi32(i),
+				 _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+						   8, 9, 10, 11, 12, 13, 14, 15)),
+		_mm512_set1_epi32(ds));
+
+	return _mm512_i32gather_ps(idx, a, sizeof(real_t));
+}
+#else
+#define VEC __m512d
+#define VW 8
+#define VLOADU(p) _mm512_loadu_pd(p)
+#define VSTOREU(p, v) _mm512_storeu_pd(p, v)
+#define VMUL(a, b) _mm512_mul_pd(a, b)
+#define VADD(a, b) _mm512_add_pd(a, b)
+#define VSQRT(a) _mm512_sqrt_pd(a)
+#define VMAX(a, b) _mm512_max_pd(a, b)
+#define VCVT_F32(p) _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define VCVT_S16(p) _mm512_cvtepi32_pd(_mm256_cvtepi16_epi32( \
+		_mm_loadu_si128((const __m128i *)(p))))
+#define VCVT_S32(p) _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i *)(p)))
+
+KERN_FN __m512d KERN(sumsq_pairs)(const real_t *p)
+{
+	const __m512i re = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+	const __m512i im = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+	__m512d a = _mm512_loadu_pd(p), b = _mm512_loadu_pd(p+8);
+
+	a = _mm512_mul_pd(a, a);
+	b = _mm512_mul_pd(b, b);
+	return _mm512_add_pd(_mm512_permutex2var_pd(a, re, b), _mm512_permutex2var_pd(a, im, b));
+}
+
+KERN_FN __m512d KERN(gather)(const real_t *a, int i, int ds)
+{
+	__m256i idx = _mm256_mullo_epi32(
+		_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+		_mm256_set1_epi32(ds));
+
+	return _mm512_i32gather_pd(idx, a, sizeof(real_t));
+}
+#endif
+
+static bool KERN(supported)(void)
+{
+	return __builtin_cpu_supports("avx512f");
+}
+
+#define VEND() _mm256_zeroupper()
+
+#include "kern-simd.h"
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "kern.h"
+
+static bool scalar_supported(void) { return true; }
+
+/*
+ * Generate a scalar conversion kernel, named after the type converted with prefix
+ * scalar_convert_.
+ */
+#define SCALAR_CONVERT(name, type) \
+static void scalar_convert_##name(const type *in, const real_t *w, real_t *out, uint n) \
+{ \
+	if (w) { \
+		for (uint i = 0; i < n; ++i) \
+			out[i] = (real_t)in[i]*w[i]; \
+	} else { \
+		for (uint i = 0; i < n; ++i) \
+			out[i] = in[i]; \
+	} \
+}
+
+SCALAR_CONVERT(f32, float)
+SCALAR_CONVERT(s16, int16_t)
+SCALAR_CONVERT(s32, int32_t)
+
+const kern_t kern_scalar = {
+	"scalar",
+	scalar_supported,
+	scalar_convert_f32,
+	scalar_convert_s16,
+	scalar_convert_s32,
+	window_apply,
+	decimate,
+	hps_argmax
+};
+
+// Defined by the files of the architecture being built for.
+extern const kern_t kern_sse2, kern_avx2, kern_avx512, kern_neon;
+
+// Fastest first.
+const kern_t *kern_variants[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	&kern_avx512,
+	&kern_avx2,
+	&kern_sse2,
+#endif
+#ifdef __aarch64__
+	&kern_neon,
+#endif
+	&kern_scalar
+};
+
+const uint kern_nvariants = sizeof(kern_variants)/sizeof(kern_variants[0]);
+
+const kern_t *kern = &kern_scalar;
+
+bool kern_init(const char *name)
+{
+	const kern_t *k;
+
+	for (uint i = 0; i < kern_nvariants; ++i) {
+		k = kern_variants[i];
+		if (name && strcmp(name, k->name) != 0)
+			continue;
+		if (!k->supported()) {
+			if (name) {
+				eprintf("%s kernels not supported by this CPU", name);
+				return false;
+			}
+			continue;
+		}
+		kern = k;
+		return true;
+	}
+	eprintf("unknown kernels %s", name);
+	return false;
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Kernels of the hot loops of processing, with SIMD variants picked at start up
+ * by what the CPU supports. The scalar kernels are the reference implementation that
+ * every variant must match.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef KERN_H
+#define KERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include "real.h"
+#include "math.h"
+#include "err.h"
+
+struct kernels {
+	const char *name;
+	// Whether the CPU running the program supports the kernels.
+	bool (*supported)(void);
+	// Convert samples of a numeric type into reals, multiplied by window w unless it's NULL.
+	void (*convert_f32)(const float *in, const real_t *w, real_t *out, uint n);
+	void (*convert_s16)(const int16_t *in, const real_t *w, real_t *out, uint n);
+	void (*convert_s32)(const int32_t *in, const real_t *w, real_t *out, uint n);
+	// See window_apply(), decimate() and hps_argmax() in math.h.
+	void (*window)(real_t *restrict a, const real_t *restrict w, int n);
+	void (*decimate)(const real_t *in, const real_t *taps, uint ntaps, uint factor,
+			 const real_t *w, real_t *out, uint n);
+	uint (*hps_argmax)(fft_complex *c, uint lo, uint hi, uint len, uint n);
+};
+
+typedef struct kernels kern_t;
+
+extern const kern_t kern_scalar;
+// Variants only exist for the architecture being built for, so aren't listed here. Go through
+// kern_variants instead.
+extern const kern_t *kern_variants[];
+extern const uint kern_nvariants;
+
+// Kernels in use, the scalar kernels until kern_init() picks the best. Shared by every
+// frequency data in the process, so picked once before they're processed on other threads.
+extern const kern_t *kern;
+
+/*
+ * kern_init - Pick the kernels to use
+ * @name: name of the kernels to use, or NULL to pick the fastest kernels the CPU supports
+ *
+ * Return false if the named kernels don't exist or aren't supported by the CPU.
+ */
+bool kern_init(const char *name);
+
+#endif
@@ -6,36 +6,313 @@
  * Copyright (C) 2021 Petar Turukalo
  */
 #include <stdlib.h>
+#include <unistd.h>
 #include "gtune.h"
+#include "calib.h"
 #include "sig.h"
 #include "err.h"
 
-gtune_t g = { 0 };
+// Maximum number of sources tuned at once, each given with a -i option.
+#define MAX_TUNERS 16
+
+static gtune_t tuners[MAX_TUNERS];
+static uint ntuners = 0;  // Number of initialised tuners.
 
 /*
  * cleanup - Clean up the program at exit
  */
 void cleanup(void)
 {
-	gtune_cleanup(&g);
+	for (uint i = 0; i < ntuners; ++i)
+		gtune_cleanup(&tuners[i]);
+}
+
+/*
+ * stop - Stop the tuners when the program is asked to exit, so that they're cleaned up
+ *	once they're no longer running
+ */
+static void stop(void)
+{
+	for (uint i = 0; i < ntuners; ++i)
+		gtune_stop(&tuners[i]);
+}
+
+/*
+ * report - Print the statistics of the tuners when asked for them with SIGUSR1
+ */
+static void report(void)
+{
+	for (uint i = 0; i < ntuners; ++i)
+		gtune_print_stats(&tuners[i]);
+}
+
+static void usage(FILE *fp)
+{
+	fprintf(fp,
+		"usage: gtune [-o] [-i SOURCE] [-C NCHANNELS] [-r RATE] [-f FORMAT] [-c CHUNKSZ]\n"
+		"             [-s NSTEPS] [-w WINDOW] [-e ESTIMATOR] [-I INTERP] [-D FACTOR] [-d SECS]\n"
+		"             [-K KERNELS] [-S PATH] [-P PLANNER] [-W PATH] [-t NTHREADS] [-T CHUNKSZ]\n"
+		"             [-F FPS] [-O FORMAT] [-M PATH] [-A TARGETS]\n"
+		"  -i SOURCE   audio input: mic[:DEVICE] (default, DEVICE is an input device's index\n"
+		"              or part of its name), wav:PATH, raw[:PATH] (stdin if no path) or\n"
+		"              synth:FREQ[,FREQ...] (a note per channel). Repeat to tune several\n"
+		"              sources at once, each on its own thread (up to %d)\n"
+		"  -C NCHANNELS number of channels to track the pitch of in parallel, such as 6 for a\n"
+		"              hexaphonic pickup (default 1, or a channel per synth note)\n"
+		"  -r RATE     sample rate in Hz of the mic, raw and synth sources (default 44100)\n"
+		"  -f FORMAT   sample format of the mic, raw and synth sources: float32 (default),\n"
+		"              int32 or int16\n"
+		"  -c CHUNKSZ  number of samples processed per frequency (default 32768)\n"
+		"  -s NSTEPS   number of steps to pass a whole chunk (default 4)\n"
+		"  -w WINDOW   window run on samples before FFT: hann (default), blackman-harris,\n"
+		"              kaiser or kaiser:BETA (default beta 8.6)\n"
+		"  -e ESTIMATOR how the frequency of a chunk is estimated: hps (default), the harmonic\n"
+		"              product spectrum, mpm, the McLeod pitch method, which only needs\n"
+		"              chunks of 2 periods of the lowest note, e.g. -c 2048 for low E, or\n"
+		"              sdft, sliding DFTs of the notes updated per sample, whose cost doesn't\n"
+		"              grow with NSTEPS\n"
+		"  -I INTERP   estimate of the frequency from between FFT bins: gaussian (default),\n"
+		"              parabolic or none (only as accurate as RATE/CHUNKSZ Hz)\n"
+		"  -D FACTOR   low-pass filter and downsample by this factor before FFT, 1 for none\n"
+		"              (default the largest that keeps the harmonics of the highest note)\n"
+		"  -d SECS     number of seconds the synth source generates (default 10, <= 0 for no end)\n"
+		"  -K KERNELS  processing kernels: avx512, avx2, sse2, neon or scalar (default the\n"
+		"              fastest the CPU supports)\n"
+		"  -S PATH     file to write latency and lost sample statistics to on SIGUSR1\n"
+		"              (default stderr)\n"
+		"  -P PLANNER  how hard to search for the fastest FFT plan: measure (default), or\n"
+		"              patient or exhaustive, which are slow but cached for later runs\n"
+		"  -W PATH     FFTW wisdom cache file, or none (default in ~/.cache/gtune)\n"
+		"  -t NTHREADS number of threads to run FFTs on (default 1)\n"
+		"  -T CHUNKSZ  smallest chunk size to run FFTs on multiple threads for (default 65536)\n"
+		"  -F FPS      most times a second the display is redrawn, only when notes change,\n"
+		"              or live records are flushed (default 30)\n"
+		"  -O FORMAT   output: text (default, the display or offline pitch track), or a\n"
+		"              record per channel of each hop as jsonl or binary (see stream.h)\n"
+		"  -M PATH     file to publish the latest pitch in for other processes to read\n"
+		"              without system calls, such as /dev/shm/gtune (see pub.h)\n"
+		"  -A TARGETS  calibrate RATE (mic and synth only), CHUNKSZ, NSTEPS and the harmonic\n"
+		"              product spectrum order at start up, overriding -r, -c and -s, to the\n"
+		"              most often refreshing settings within a budget of cents=N or hz=N\n"
+		"              (error), latency=SECS and cpu=FRACTION of a CPU shared by all sources\n"
+		"              (default cents=5,latency=0.5,cpu=0.5)\n"
+		"  -o          offline mode: print a timestamped pitch track and read files as fast as possible\n",
+		MAX_TUNERS);
+}
+
+/*
+ * parse_uint - Parse a positive integer command line argument
+ */
+static bool parse_uint(const char *s, uint *n)
+{
+	char *end;
+	unsigned long l = strtoul(s, &end, 10);
+
+	if (*s == '\0' || *end != '\0' || l == 0 || l > UINT_MAX) {
+		eprintf("bad number %s", s);
+		return false;
+	}
+	*n = l;
+	return true;
+}
+
+/*
+ * parse_args - Parse the command line into the parameters shared by all tuners
+ * @srcs: out-param source descriptions given with -i, one per tuner
+ * @nsrcs: out-param number of sources given, 0 for the default source
+ * @targets: out-param budget to calibrate the tuners' settings to, if given with -A
+ * @calibrate: out-param whether the tuners' settings are calibrated
+ */
+static bool parse_args(int argc, char *argv[], struct gtune_params *p, const char **srcs,
+		       uint *nsrcs, struct calib_targets *targets, bool *calibrate)
+{
+	struct source_params src;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:C:r:f:c:s:w:e:I:D:d:K:S:P:W:t:T:F:O:M:A:oh")) != -1) {
+		switch (opt) {
+			case 'i':
+				src = p->src;
+				if (!source_parse(optarg, &src))
+					return false;
+				if (*nsrcs == MAX_TUNERS) {
+					eprintf("more than %d sources", MAX_TUNERS);
+					return false;
+				}
+				srcs[(*nsrcs)++] = optarg;
+				break;
+			case 'C':
+				if (!parse_uint(optarg, &p->src.nchannels))
+					return false;
+				break;
+			case 'r':
+				if (!parse_uint(optarg, &p->src.sample_rate))
+					return false;
+				break;
+			case 'f':
+				if (!source_parse_fmt(optarg, &p->src.fmt))
+					return false;
+				break;
+			case 'c':
+				if (!parse_uint(optarg, &p->chunksz))
+					return false;
+				break;
+			case 's':
+				if (!parse_uint(optarg, &p->chunk_nsteps))
+					return false;
+				break;
+			case 'w':
+				if (!fdata_parse_window(optarg, &p->freq))
+					return false;
+				break;
+			case 'e':
+				if (!fdata_parse_estimator(optarg, &p->freq))
+					return false;
+				break;
+			case 'I':
+				if (!fdata_parse_interp(optarg, &p->freq))
+					return false;
+				break;
+			case 'D':
+				if (!parse_uint(optarg, &p->freq.decimation))
+					return false;
+				break;
+			case 'd':
+				p->src.synth_secs = atof(optarg);
+				break;
+			case 'K':
+				p->kernels = optarg;
+				break;
+			case 'S':
+				p->stats_path = optarg;
+				break;
+			case 'P':
+				if (!fdata_parse_planner(optarg, &p->freq))
+					return false;
+				break;
+			case 'W':
+				if (strcmp(optarg, "none") == 0) {
+					p->freq.wisdom_path[0] = '\0';
+				} else if (strlen(optarg) >= sizeof(p->freq.wisdom_path)) {
+					eprintf("wisdom path too long");
+					return false;
+				} else {
+					strcpy(p->freq.wisdom_path, optarg);
+				}
+				break;
+			case 't':
+				if (!parse_uint(optarg, &p->freq.fft_nthreads))
+					return false;
+				break;
+			case 'T':
+				if (!parse_uint(optarg, &p->freq.fft_threads_min))
+					return false;
+				break;
+			case 'F':
+				if (!parse_uint(optarg, &p->fps))
+					return false;
+				break;
+			case 'O':
+				if (!stream_parse_format(optarg, &p->output))
+					return false;
+				break;
+			case 'M':
+				p->pub_path = optarg;
+				break;
+			case 'A':
+				if (!calib_parse(optarg, targets))
+					return false;
+				*calibrate = true;
+				break;
+			case 'o':
+				p->offline = true;
+				break;
+			case 'h':
+				usage(stdout);
+				exit(EXIT_SUCCESS);
+			default:
+				usage(stderr);
+				return false;
+		}
+	}
+	if (optind < argc) {
+		usage(stderr);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * init_tuner - Initialise the tuner of a source given with -i
+ * @p: parameters shared by all tuners
+ * @src: description of the tuner's source
+ * @nsrcs: number of sources given. With more than one, each tuner is labelled with its source
+ *	and writes its statistics and publishes its pitch to files of its own, the stats and
+ *	publication paths suffixed with its number.
+ */
+static bool init_tuner(gtune_t *g, struct gtune_params *p, const char *src, uint nsrcs)
+{
+	static char stats_paths[MAX_TUNERS][PATH_MAX];
+	static char pub_paths[MAX_TUNERS][PATH_MAX];
+	struct gtune_params tp = *p;
+
+	if (src && !source_parse(src, &tp.src))
+		return false;
+	tp.index = ntuners;
+	if (nsrcs > 1) {
+		tp.label = src;
+		if (p->stats_path) {
+			if (snprintf(stats_paths[ntuners], PATH_MAX, "%s.%u", p->stats_path, ntuners+1) >= PATH_MAX) {
+				eprintf("stats path too long");
+				return false;
+			}
+			tp.stats_path = stats_paths[ntuners];
+		}
+		if (p->pub_path) {
+			if (snprintf(pub_paths[ntuners], PATH_MAX, "%s.%u", p->pub_path, ntuners+1) >= PATH_MAX) {
+				eprintf("publication path too long");
+				return false;
+			}
+			tp.pub_path = pub_paths[ntuners];
+		}
+	}
+	return gtune_init(g, &tp);
 }
 
 int main(int argc, char *argv[])
 {
-	bool success;
+	struct gtune_params p;
+	const char *srcs[MAX_TUNERS];
+	struct calib_targets targets;
+	bool calibrate = false;
+	uint nsrcs = 0;
 
 	err_set_prgname(argv[0]);
+	gtune_params_default(&p);
+	calib_targets_default(&targets);
+	if (!parse_args(argc, argv, &p, srcs, &nsrcs, &targets, &calibrate))
+		return EXIT_FAILURE;
+	// Calibrated to the first source, which the others share their settings with.
+	if (calibrate && ((nsrcs && !source_parse(srcs[0], &p.src)) ||
+			  !calib_configure(&p, &targets, nsrcs ? nsrcs : 1)))
+		return EXIT_FAILURE;
+	if (p.output != STREAM_NONE && !stream_init(stdout))
+		return EXIT_FAILURE;
 	sig_block();
 
-	success = gtune_init(&g, 44100, 32768, 4, 20, 1500, paFloat32);
-	if (!success) {
-		eprintf("failed to init gtune");
-		return EXIT_FAILURE;
-	}
 	atexit(cleanup);
-	sig_handle();
+	// The tuners share the one portaudio session and FFTW's plans, so a tuner of the same chunk
+	// size as one before it reuses its plan rather than measure another.
+	for (; ntuners < (nsrcs ? nsrcs : 1); ++ntuners) {
+		if (!init_tuner(&tuners[ntuners], &p, nsrcs ? srcs[ntuners] : NULL, nsrcs)) {
+			eprintf("failed to init gtune");
+			return EXIT_FAILURE;
+		}
+	}
+	if (!sig_handle(stop, report))
+		return EXIT_FAILURE;
 
-	gtune_start(&g);
-	// This shouldn't be reached.
-	return EXIT_FAILURE;
+	// Only returns when the sources come to an end, which the microphone never does, or the
+	// program is asked to exit.
+	return gtune_start_all(tuners, ntuners) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
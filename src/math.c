@@ -5,21 +5,31 @@
  */
 #include "math.h"
 
-double magnitude(fftw_complex c)
+real_t magnitude(fft_complex c)
 {
 	// Element at index 0 is real part, element at index 1 is complex part.
-	return sqrt(c[0]*c[0] + c[1]*c[1]);
+	return real_sqrt(c[0]*c[0] + c[1]*c[1]);
 }
 
-void magnitudes(fftw_complex *c, double *out_magnitudes, int n)
+void magnitudes(fft_complex *c, real_t *out_magnitudes, int n)
 {
 	for (int i = 0; i < n; ++i) 
 		out_magnitudes[i] = magnitude(c[i]);
 }
 
-double frequency(int sample_rate, int bin_index, int nbins)
+double frequency(int sample_rate, double bin_index, int nbins)
 {
-	return (sample_rate*bin_index)/(double)nbins;
+	return (sample_rate*bin_index)/nbins;
+}
+
+double parabolic_offset(double l, double c, double r)
+{
+	double d = l - 2*c + r;
+
+	// A parabola that doesn't open downwards has no peak.
+	if (d >= 0)
+		return 0;
+	return 0.5*(l - r)/d;
 }
 
 /*
@@ -58,15 +68,15 @@ double nr_new_range(double n, double start, double end, double new_start, double
 	return new_start+nr_prcnt_over_range(n, start, end)*rangelen;
 }
 
-void hps(double *magnitudes, double *out_hps, int len, int n)
+void hps(real_t *magnitudes, real_t *out_hps, int nout, int len, int n)
 {
 	int ds, end, i;
 
-	memcpy(out_hps, magnitudes, len*sizeof(double));
+	memcpy(out_hps, magnitudes, nout*sizeof(real_t));
 
 	// Skip downsampling first since already done by memcpy.
 	for (ds = 2; ds <= n; ++ds) {
-		end = len/ds;
+		end = len/ds < nout ? len/ds : nout;
 		for (i = 0; i < end; ++i)
 			out_hps[i] *= magnitudes[i*ds];
 	}
@@ -80,8 +90,143 @@ double hann(int i, int n)
 	return 0.5*(1-cos((2*M_PI*i)/(n-1)));
 }
 
-void hanning_window(double *a, int n)
+/*
+ * blackman_harris - Compute the 4-term Blackman-Harris function for a number i in range 0 <= i < n.
+ *
+ * Its side lobes are far lower than Hanning's (-92 dB against -31 dB), at the cost of a main
+ * lobe twice as wide.
+ */
+static double blackman_harris(int i, int n)
+{
+	double x = (2*M_PI*i)/(n-1);
+
+	return 0.35875 - 0.48829*cos(x) + 0.14128*cos(2*x) - 0.01168*cos(3*x);
+}
+
+/*
+ * bessel_i0 - Compute the zeroth order modified Bessel function of the first kind
+ *
+ * Sums its power series until the terms no longer make a difference.
+ */
+static double bessel_i0(double x)
+{
+	double term = 1, sum = 1;
+
+	for (int k = 1; term > sum*1e-16; ++k) {
+		term *= (x/(2*k))*(x/(2*k));
+		sum += term;
+	}
+	return sum;
+}
+
+/*
+ * kaiser - Compute the Kaiser function for a number i in range 0 <= i < n.
+ * @beta: shape of the window. 0 is rectangular, and larger trades a wider main lobe
+ *	for lower side lobes
+ */
+static double kaiser(int i, int n, double beta)
+{
+	double r = (2.0*i)/(n-1) - 1;
+
+	return bessel_i0(beta*sqrt(1-r*r))/bessel_i0(beta);
+}
+
+void window_fill(real_t *w, int n, window_type type, double kaiser_beta)
+{
+	// A single sample has nothing to taper.
+	if (n == 1) {
+		w[0] = 1;
+		return;
+	}
+	for (int i = 0; i < n; ++i) {
+		switch (type) {
+			case WINDOW_HANN:
+				w[i] = hann(i, n);
+				break;
+			case WINDOW_BLACKMAN_HARRIS:
+				w[i] = blackman_harris(i, n);
+				break;
+			case WINDOW_KAISER:
+				w[i] = kaiser(i, n, kaiser_beta);
+				break;
+		}
+	}
+}
+
+void lowpass_fill(real_t *taps, int n, double cutoff, double kaiser_beta)
+{
+	double x, sum = 0;
+
+	for (int i = 0; i < n; ++i) {
+		x = i - (n-1)/2.0;
+		taps[i] = (x == 0 ? 2*cutoff : sin(2*M_PI*cutoff*x)/(M_PI*x)) * kaiser(i, n, kaiser_beta);
+		sum += taps[i];
+	}
+	for (int i = 0; i < n; ++i)
+		taps[i] /= sum;
+}
+
+void decimate(const real_t *in, const real_t *taps, uint ntaps, uint factor, const real_t *w,
+	      real_t *out, uint n)
+{
+	real_t sum;
+
+	for (uint i = 0; i < n; ++i, in += factor) {
+		sum = 0;
+		for (uint k = 0; k < ntaps; ++k)
+			sum += in[k]*taps[k];
+		out[i] = sum*w[i];
+	}
+}
+
+/*
+ * sumsq - Get the squared magnitude of a complex number
+ */
+static real_t sumsq(fft_complex c)
+{
+	return c[0]*c[0] + c[1]*c[1];
+}
+
+real_t hps_product(fft_complex *c, uint i, uint len, uint n)
+{
+	real_t p = HPS_POWER(sumsq(c[i]));
+
+	// Multiplied in the same order as hps().
+	for (uint ds = 2; ds <= n && i < len/ds; ++ds)
+		p *= HPS_POWER(sumsq(c[i*ds]));
+	return p;
+}
+
+uint hps_argmax(fft_complex *c, uint lo, uint hi, uint len, uint n)
+{
+	real_t first = hps_product(c, lo, len, n);
+	real_t max = first, p;
+	uint maxi = lo;
+
+	for (uint i = lo+1; i <= hi; ++i) {
+		p = hps_product(c, i, len, n);
+		if (p >= max) {
+			max = p;
+			maxi = i;
+		}
+	}
+	// Break ties the same way as maxi_real().
+	return first == max ? lo : maxi;
+}
+
+uint maxi_real(real_t *a, uint n)
+{
+	uint mi = 0;
+
+	while (--n) {
+		if (a[n] > a[mi])
+			mi = n;
+	}
+	return mi;
+}
+
+void window_apply(real_t *restrict a, const real_t *restrict w, int n)
 {
 	for (int i = 0; i < n; ++i)
-		a[i] *= hann(i, n);
+		a[i] *= w[i];
 }
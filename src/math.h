@@ -10,19 +10,20 @@
 
 #include <math.h>
 #include <string.h>
-#include <fftw3.h>
+#include <sys/types.h>
+#include "real.h"
 
 /*
  * magnitude - Get the magnitude of a complex number
  */
-double magnitude(fftw_complex c);
+real_t magnitude(fft_complex c);
 
 /*
  * magnitudes - Get the magnitudes of multiple complex numbers
  * @c: array of complex numbers
  * @n: number of magnitudes to calculate 
  */
-void magnitudes(fftw_complex *c, double *out_magnitudes, int n);
+void magnitudes(fft_complex *c, real_t *out_magnitudes, int n);
 
 /*
  * nr_new_range - Convert a number in a current range to a new range
@@ -40,25 +41,144 @@ double nr_new_range(double n, double start, double end, double new_start, double
 /*
  * frequency - Calculate the frequency of an index in the frequency domain
  * @sample_rate: sample rate from time domain before conversion to frequency domain
- * @bin_index: index of frequency bin in frequency domain
+ * @bin_index: index of frequency bin in frequency domain, which can be fractional for a
+ *	frequency between bins
  * @nbins: number of bins in the frequency domain
  */
-double frequency(int sample_rate, int bin_index, int nbins);
+double frequency(int sample_rate, double bin_index, int nbins);
+
+/*
+ * parabolic_offset - Get the offset of the vertex of the parabola through three equally
+ *	spaced points from the middle point, in range -0.5 to 0.5 if the middle is the highest
+ * @l: value of the point to the left
+ * @c: value of the middle point
+ * @r: value of the point to the right
+ *
+ * Return 0 if the points don't make a peak.
+ */
+double parabolic_offset(double l, double c, double r);
 
 /*
  * Run a harmonic product spectrum (HPS) on magnitudes to ignore harmonics and find the fundamental
  * frequency of a note.
  * @out_hps: out-param where hps-processed magnitudes are stored
- * @len: length of both arrays
+ * @nout: number of hps-processed magnitudes to compute, the first of them, up to len
+ * @len: number of magnitudes. Downsampled magnitudes past the end aren't multiplied in
+ * @n: number of times to downsample and largest downsample integer
+ */
+void hps(real_t *magnitudes, real_t *out_hps, int nout, int len, int n);
+
+/*
+ * HPS_POWER - Get what the harmonic product spectrum of complex numbers multiplies together
+ *	for a bin, given its squared magnitude
+ *
+ * The product of squared magnitudes is the square of the product of magnitudes, so peaks at
+ * the same bin without a square root per bin. Single-precision reals don't have the range for
+ * it, so take the square root. Samples are always scaled into range -1 to 1 before their FFT
+ * (see fdata_process_chunk()), so a magnitude is at most half the window's sum, under 2^15 for
+ * chunks of 65536, and the products of magnitudes of the highest orders stay far below the
+ * largest float where their squares wouldn't.
+ */
+#ifdef GTUNE_FLOAT
+#define HPS_POWER(sumsq) real_sqrt(sumsq)
+#else
+#define HPS_POWER(sumsq) (sumsq)
+#endif
+
+/*
+ * hps_product - Get the harmonic product spectrum of a single bin straight from the complex
+ *	numbers, of their HPS_POWER()s
+ * @c: complex numbers, the output of an FFT
+ * @i: bin
+ * @len: number of complex numbers whose magnitudes are multiplied in
+ * @n: number of times to downsample and largest downsample integer
+ */
+real_t hps_product(fft_complex *c, uint i, uint len, uint n);
+
+/*
+ * hps_argmax - Get the bin of the max of the harmonic product spectrum of complex numbers
+ *	within a band of bins, without storing either their magnitudes or the spectrum
+ * @c: complex numbers, the output of an FFT
+ * @lo: lowest bin of the band
+ * @hi: highest bin of the band (inclusive)
+ * @len: number of complex numbers whose magnitudes are multiplied in, see hps()
  * @n: number of times to downsample and largest downsample integer
+ *
+ * Peaks at the same bin as magnitudes(), then hps() of bins up to hi, then maxi_real() of those
+ * from lo, with ties broken the same way. The SIMD kernels of it process HPS_BLOCKSZ bins at a
+ * time, so that their products are still in cache when searched for the max.
  */
-void hps(double *magnitudes, double *out_hps, int len, int n);
+uint hps_argmax(fft_complex *c, uint lo, uint hi, uint len, uint n);
+
+#define HPS_BLOCKSZ 512
 
 /*
- * hanning_window - Run a hanning window on an array (in-place)
- * @a: array to run Hanning window on
+ * maxi_real - Get the index of the maximum value in an array of reals
+ * @a: array of reals
  * @n: length of array
+ *
+ * Assumes the array has at least 1 element.
+ */
+uint maxi_real(real_t *a, uint n);
+
+typedef enum {
+	WINDOW_HANN,
+	WINDOW_BLACKMAN_HARRIS,
+	WINDOW_KAISER
+} window_type;
+
+/*
+ * hann - Compute the Hanning function for a number i in range 0 <= i < n.
+ */
+double hann(int i, int n);
+
+/*
+ * window_fill - Compute the coefficients of a window function
+ * @w: out-param array where to store the coefficients
+ * @n: length of the window
+ * @type: shape of the window
+ * @kaiser_beta: shape parameter of a Kaiser window, unused by other windows
+ *
+ * Windowing is done by multiplying samples by the coefficients with window_apply(), so
+ * the coefficients, which cost a cos() or more each, only need computing once per window length.
+ */
+void window_fill(real_t *w, int n, window_type type, double kaiser_beta);
+
+/*
+ * lowpass_fill - Compute the taps of a low-pass FIR filter, a Kaiser windowed sinc
+ * @taps: out-param array where to store the taps
+ * @n: number of taps, odd so that the filter is centred on its middle tap
+ * @cutoff: cutoff frequency as a fraction of the sample rate, less than 0.5
+ * @kaiser_beta: shape of the Kaiser window, which trades a wider transition band for
+ *	more attenuation past it
+ *
+ * The taps are scaled for a gain of 1 at 0 Hz.
+ */
+void lowpass_fill(real_t *taps, int n, double cutoff, double kaiser_beta);
+
+/*
+ * decimate - Low-pass filter and downsample an array, keeping every factor'th sample
+ * @in: array to decimate, of at least (n-1)*factor + ntaps elements
+ * @taps: taps of the low-pass filter
+ * @ntaps: number of taps
+ * @factor: number of input samples per output sample
+ * @w: window coefficients to multiply the output by
+ * @out: out-param array of n decimated samples, where out[i] is the filtered sample at
+ *	in[i*factor + c] for a filter centred on tap c
+ * @n: number of output samples
+ *
+ * Only the samples that are kept are filtered, which is the same work as a polyphase
+ * decimator: each output sample costs ntaps multiplies rather than ntaps*factor.
+ */
+void decimate(const real_t *in, const real_t *taps, uint ntaps, uint factor, const real_t *w,
+	      real_t *out, uint n);
+
+/*
+ * window_apply - Run a window on an array (in-place)
+ * @a: array to run window on
+ * @w: window coefficients computed by window_fill()
+ * @n: length of both arrays
  */
-void hanning_window(double *a, int n);
+void window_apply(real_t *restrict a, const real_t *restrict w, int n);
 
 #endif
@@ -5,81 +5,278 @@
  */
 #include "mic.h"
 
+// Minimum number of init-time read sizes the ring buffer holds.
+#define MIC_RING_NREADS 8
+
+// The portaudio session shared by all microphones, initialised by the first to be opened and
+// terminated by the last to be closed.
+static pthread_mutex_t pa_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint pa_nusers = 0;
+
+static bool pa_acquire(void)
+{
+	PaError err = paNoError;
+
+	pthread_mutex_lock(&pa_lock);
+	if (pa_nusers == 0)
+		err = Pa_Initialize();
+	if (err == paNoError)
+		++pa_nusers;
+	pthread_mutex_unlock(&pa_lock);
+	if (err != paNoError) {
+		eprintf("couldn't init portaudio: %s", Pa_GetErrorText(err));
+		return false;
+	}
+	return true;
+}
+
+static void pa_release(void)
+{
+	pthread_mutex_lock(&pa_lock);
+	if (--pa_nusers == 0)
+		Pa_Terminate();
+	pthread_mutex_unlock(&pa_lock);
+}
+
+/*
+ * Get whether a string contains another, ignoring case.
+ */
+static bool contains_nocase(const char *s, const char *sub)
+{
+	size_t n = strlen(sub);
+
+	for (; *s; ++s) {
+		if (strncasecmp(s, sub, n) == 0)
+			return true;
+	}
+	return n == 0;
+}
+
 /*
- * Set default parameters for the microphone.
- * Return whether could successfully get the default microphone for setting.
+ * Print the input devices to choose from, for when a device isn't found.
  */
-static bool mic_set_params(PaStreamParameters *p, PaSampleFormat fmt)
+static void print_input_devices(void)
+{
+	const PaDeviceInfo *dev;
+	int n = Pa_GetDeviceCount();
+
+	fprintf(stderr, "input devices:\n");
+	for (int i = 0; i < n; ++i) {
+		dev = Pa_GetDeviceInfo(i);
+		if (dev->maxInputChannels > 0)
+			fprintf(stderr, "  %d: %s (%d channel(s))\n", i, dev->name, dev->maxInputChannels);
+	}
+}
+
+/*
+ * Find an input device by its index, or the first whose name contains the given text.
+ */
+static PaDeviceIndex find_device(const char *device)
+{
+	const PaDeviceInfo *dev;
+	int n = Pa_GetDeviceCount();
+	char *end;
+	long i = strtol(device, &end, 10);
+
+	if (*device != '\0' && *end == '\0') {
+		if (i >= 0 && i < n && Pa_GetDeviceInfo(i)->maxInputChannels > 0)
+			return i;
+	} else {
+		for (i = 0; i < n; ++i) {
+			dev = Pa_GetDeviceInfo(i);
+			if (dev->maxInputChannels > 0 && contains_nocase(dev->name, device))
+				return i;
+		}
+	}
+	eprintf("no audio input device %s", device);
+	print_input_devices();
+	return paNoDevice;
+}
+
+/*
+ * Set parameters for the microphone's device, the default input device if none is given,
+ * printing which device it is if verbose. Return whether could successfully get the device
+ * for setting.
+ */
+static bool mic_set_params(PaStreamParameters *p, PaSampleFormat fmt, uint nchannels,
+			   const char *device, bool verbose)
 {
 	const PaDeviceInfo *dev;
 	const PaHostApiInfo *host;
 
-	p->device = Pa_GetDefaultInputDevice();
+	p->device = device ? find_device(device) : Pa_GetDefaultInputDevice();
 	if (p->device == paNoDevice) 
 		return false;
 	dev = Pa_GetDeviceInfo(p->device);
-	host = Pa_GetHostApiInfo(dev->hostApi);
-	printf("using %s %s audio input device\n", host->name, dev->name);
+	if (verbose) {
+		host = Pa_GetHostApiInfo(dev->hostApi);
+		fprintf(stderr, "using %s %s audio input device\n", host->name, dev->name);
+	}
+	if (dev->maxInputChannels < (int)nchannels) {
+		eprintf("audio input device has %d channel(s), fewer than the %u to capture",
+			dev->maxInputChannels, nchannels);
+		return false;
+	}
 
-	// Use 1 channel for now since multiple will only help with redundancy (as in all channels
-	// producing the same note) and not with getting a note reading faster unless gtune is refactored 
-	// to work in parallel, e.g. with threads handling separate channels.
-	p->channelCount = 1;
+	// Each channel is tracked separately, such as a string each of a hexaphonic pickup.
+	p->channelCount = nchannels;
 	p->sampleFormat = fmt;
 	p->suggestedLatency = dev->defaultLowInputLatency;
 	p->hostApiSpecificStreamInfo = NULL;
 	return true;
 }
 
-bool mic_init(mic_t *m, uint sample_rate, uint readsz, PaSampleFormat fmt)
+/*
+ * mic_callback - Capture callback run by portaudio on its own thread each time a buffer
+ *	of samples has been recorded
+ *
+ * Hands the samples to the processing thread through the lock-free ring buffer. This must
+ * never block, so if the processing thread has fallen so far behind that the ring buffer is
+ * full the samples are dropped and counted as an overrun.
+ */
+static int mic_callback(const void *input, void *output, unsigned long nframes,
+			const PaStreamCallbackTimeInfo *time, PaStreamCallbackFlags flags, void *data)
+{
+	mic_t *m = data;
+
+	if (flags & paInputOverflow)
+		atomic_fetch_add_explicit(&m->overflows, 1, memory_order_relaxed);
+	if (input && spsc_push(&m->ring, input, nframes*m->framesz))
+		sem_post(&m->ready);
+	else
+		atomic_fetch_add_explicit(&m->overruns, 1, memory_order_relaxed);
+	return paContinue;
+}
+
+/*
+ * mic_ringsz - Get the size in bytes of the ring buffer between capture and processing
+ *
+ * Big enough to ride out at least a second's worth of processing stalls.
+ */
+static size_t mic_ringsz(uint sample_rate, uint readsz, uint framesz)
+{
+	size_t n = readsz*MIC_RING_NREADS;
+
+	if (n < sample_rate)
+		n = sample_rate;
+	return n*framesz;
+}
+
+bool mic_init(mic_t *m, uint sample_rate, uint readsz, PaSampleFormat fmt, uint nchannels,
+	      const char *device)
 {
 	PaError err;
 	PaStreamParameters mic_params;
 
-	err = Pa_Initialize();
-	if (err != paNoError) {
-		eprintf("couldn't init portaudio: %s", Pa_GetErrorText(err));
+	err = Pa_GetSampleSize(fmt);
+	if (err == paSampleFormatNotSupported) {
+		eprintf("pulse audio sample format %lu: %s", fmt, Pa_GetErrorText(err));
 		goto mic_init_error0;
 	}
-	if (!mic_set_params(&mic_params, fmt))  {
-		eprintf("couldn't get default input device");
+	m->framesz = err*nchannels;
+	atomic_init(&m->overruns, 0);
+	atomic_init(&m->overflows, 0);
+	m->seen_discontinuities = 0;
+	if (!spsc_init(&m->ring, mic_ringsz(sample_rate, readsz, m->framesz)))
+		goto mic_init_error0;
+	if (sem_init(&m->ready, 0, 0) == -1) {
+		eprintf("couldn't init microphone semaphore: %s", strerror(errno));
 		goto mic_init_error1;
 	}
-	err = Pa_OpenStream(&m->stream, &mic_params, NULL, sample_rate, readsz, 
-			    paClipOff, NULL, NULL);
-	if (err != paNoError) {
-		eprintf("couldn't open audio input stream: %s", Pa_GetErrorText(err));
-		goto mic_init_error1;
+
+	if (!pa_acquire())
+		goto mic_init_error2;
+	if (!mic_set_params(&mic_params, fmt, nchannels, device, true))  {
+		eprintf("couldn't set up input device");
+		goto mic_init_error3;
 	}
-	err = Pa_StartStream(m->stream);
+	// Let the host pick the callback buffer size it works best with, since reads are
+	// decoupled from callbacks by the ring buffer.
+	err = Pa_OpenStream(&m->stream, &mic_params, NULL, sample_rate, paFramesPerBufferUnspecified, 
+			    paClipOff, mic_callback, m);
 	if (err != paNoError) {
-		eprintf("couldn't start audio input stream: %s", Pa_GetErrorText(err));
-		goto mic_init_error2;
+		eprintf("couldn't open audio input stream: %s", Pa_GetErrorText(err));
+		goto mic_init_error3;
 	}
 	return true;
 
+mic_init_error3:
+	pa_release();
 mic_init_error2:
-	Pa_CloseStream(m->stream);
+	sem_destroy(&m->ready);
 mic_init_error1:
-	Pa_Terminate();
+	spsc_free(&m->ring);
 mic_init_error0:
 	return false;
 }
 
-void mic_read_until_success(mic_t *m, char *samples, uint readsz)
+bool mic_supports_rate(uint sample_rate, PaSampleFormat fmt, uint nchannels, const char *device)
 {
-	PaError err;
+	PaStreamParameters mic_params;
+	bool supported;
 
-	while ((err = Pa_ReadStream(m->stream, (void *)samples, readsz)) != paNoError)
-		eprintf("failed to read audio input samples: %s", Pa_GetErrorText(err));
+	if (!pa_acquire())
+		return false;
+	supported = mic_set_params(&mic_params, fmt, nchannels, device, false) &&
+		    Pa_IsFormatSupported(&mic_params, NULL, sample_rate) == paFormatIsSupported;
+	pa_release();
+	return supported;
+}
+
+bool mic_start(mic_t *m)
+{
+	PaError err = Pa_StartStream(m->stream);
+
+	if (err != paNoError) {
+		eprintf("couldn't start audio input stream: %s", Pa_GetErrorText(err));
+		return false;
+	}
+	return true;
+}
+
+void mic_read(mic_t *m, char *samples, uint readsz)
+{
+	size_t n = readsz*m->framesz;
+	size_t popped;
+
+	while ((popped = spsc_pop(&m->ring, samples, n)) < n) {
+		samples += popped;
+		n -= popped;
+		// Each callback posts once, so wake up after the next one and try again.
+		while (sem_wait(&m->ready) == -1 && errno == EINTR)
+			;
+	}
+}
+
+bool mic_discontinuity(mic_t *m)
+{
+	unsigned long n = atomic_load_explicit(&m->overruns, memory_order_relaxed) +
+			  atomic_load_explicit(&m->overflows, memory_order_relaxed);
+	bool discontinuity = n != m->seen_discontinuities;
+
+	m->seen_discontinuities = n;
+	return discontinuity;
+}
+
+void mic_lost(mic_t *m, unsigned long *overruns, unsigned long *overflows)
+{
+	*overruns = atomic_load_explicit(&m->overruns, memory_order_relaxed);
+	*overflows = atomic_load_explicit(&m->overflows, memory_order_relaxed);
 }
 
 void mic_cleanup(mic_t *m)
 {
+	unsigned long overruns, overflows;
+
 	if (m) {
 		Pa_StopStream(m->stream);
 		Pa_CloseStream(m->stream);
-		Pa_Terminate();
+		pa_release();
+		sem_destroy(&m->ready);
+		spsc_free(&m->ring);
+
+		mic_lost(m, &overruns, &overflows);
+		if (overruns || overflows)
+			fprintf(stderr, "%lu capture overrun(s), %lu input overflow(s)\n", overruns, overflows);
 	}
 }
-
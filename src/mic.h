@@ -2,7 +2,9 @@
  * SPDX-License-Identifier: GPL-2.0
  *
  * Reading from microphone input device. 
- * Wrapper for portaudio input.
+ * Wrapper for portaudio input. Samples are captured by a portaudio callback on its own
+ * thread and handed to the reading (processing) thread through a lock-free ring buffer,
+ * so capture never stalls behind processing.
  *
  * Copyright (C) 2021 Petar Turukalo
  */
@@ -13,10 +15,23 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include <pthread.h>
+#include <strings.h>
 #include "err.h"
+#include "spsc.h"
 
 struct microphone {
 	PaStream *stream;
+	uint framesz;  // Size of a frame (a sample of each channel) in bytes.
+	spsc_t ring;  // Captured samples waiting to be read.
+	sem_t ready;  // Posted by the capture callback each time it pushes samples.
+	atomic_ulong overruns;  // Captured buffers dropped because the ring buffer was full.
+	atomic_ulong overflows;  // Captured buffers where portaudio reported its input overflowed.
+	unsigned long seen_discontinuities;  // Overruns and overflows already reported by mic_discontinuity().
 };
 
 typedef struct microphone mic_t;
@@ -24,25 +39,61 @@ typedef struct microphone mic_t;
 /*
  * mic_init - Initialise a new microphone for audio input
  * @sample_rate: samples per second (Hz)
- * @readsz: number of samples per read (although a read doesn't have to match this, but
- *	it should for performance reasons)
+ * @readsz: number of frames per read, which sizes the ring buffer between capture and reads
  * @fmt: pulse audio's description of a sample's data type
+ * @nchannels: number of channels to capture, such as 6 for a hexaphonic pickup with a
+ *	channel per string
+ * @device: index of the input device to use, or part of its name, or NULL for the default
+ *	input device
  * 
- * Uses the default microphone. Return whether the intialisation was successful. Starts the underlying
- * stream which can be stopped with mic_cleanup().
+ * Any number of microphones can be open at once, on different devices, sharing the one
+ * portaudio session. Return whether the intialisation was successful. The underlying
+ * stream isn't started until mic_start(), and is stopped with mic_cleanup().
  */
-bool mic_init(mic_t *m, uint sample_rate, uint readsz, PaSampleFormat fmt);
+bool mic_init(mic_t *m, uint sample_rate, uint readsz, PaSampleFormat fmt, uint nchannels,
+	      const char *device);
 
 /*
- * mic_read_until_success - Read samples from a microphone. If a read fails it keeps retrying 
- *	until it succeeds.
- * @samples: array to store read samples into
- * @readsz: number of samples to read (preferrably the same as the init-time read size)
+ * mic_supports_rate - Get whether a microphone can be opened to capture at a sample rate
+ * @device: index of the input device, or part of its name, or NULL for the default input
+ *	device
  *
- * Microphone must have been initialised with call to mic_init before calling this.
- * Blocks until underlying samples buffer is filled with the read size amount of samples.
+ * Takes the same parameters as mic_init(), without opening a stream.
  */
-void mic_read_until_success(mic_t *m, char *samples, uint readsz);
+bool mic_supports_rate(uint sample_rate, PaSampleFormat fmt, uint nchannels, const char *device);
+
+/*
+ * mic_start - Start recording samples from a microphone initialised with mic_init
+ *
+ * Kept separate from initialisation so that slow set up done after opening the microphone,
+ * such as FFT planning, doesn't overflow its input buffer. Return whether the stream started.
+ */
+bool mic_start(mic_t *m);
+
+/*
+ * mic_read - Read samples from a microphone
+ * @samples: array to store read samples into, interleaved if capturing multiple channels
+ * @readsz: number of frames to read
+ *
+ * Microphone must have been started with call to mic_start before calling this.
+ * Blocks until the read size amount of frames has been captured.
+ */
+void mic_read(mic_t *m, char *samples, uint readsz);
+
+/*
+ * mic_discontinuity - Get whether captured samples have been lost since the last call,
+ *	because of a capture overrun or input overflow
+ *
+ * Samples read after a loss don't follow on from those read before it.
+ */
+bool mic_discontinuity(mic_t *m);
+
+/*
+ * mic_lost - Get the number of captured buffers lost so far
+ * @overruns: out-param number of buffers dropped because the ring buffer was full
+ * @overflows: out-param number of buffers where portaudio reported its input overflowed
+ */
+void mic_lost(mic_t *m, unsigned long *overruns, unsigned long *overflows);
 
 /*
  * mic_cleanup - Clean up a microphone data structure initialised with mic_init
@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * McLeod pitch method (MPM) estimator of the frequency of a chunk of samples, after
+ * "A Smarter Way to Find Pitch" by Philip McLeod and Geoff Wyvill. The normalised square
+ * difference function (NSDF) of the chunk is 1 at lags that are whole periods of a perfectly
+ * periodic signal, so the first of its peaks that's nearly as high as the highest is the
+ * period of the fundamental, even when a harmonic is louder than it.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "freq.h"
+
+// Fraction of the highest key maximum of the NSDF the first one picked must reach. Lower picks
+// longer periods, risking a note an octave down, higher picks shorter ones, risking a harmonic.
+#define MPM_K 0.93
+// Fraction of the chunk that's the longest lag searched for a period. Longer lags have fewer
+// samples overlapping, down to a quarter of the chunk, so are noisier, but a chunk of only
+// about 2 periods needs lags past half of it to find the whole peak of the first period.
+#define MPM_MAX_LAG 0.75
+// Highest key maximum below which the chunk is taken to be noise or silence with no pitch.
+#define MPM_MIN_CLARITY 0.5
+
+/*
+ * mpm_init - Allocate the chunk zero padded to twice its length, so that the autocorrelation
+ *	computed with FFTs doesn't wrap around, and plan the FFT and its inverse
+ */
+static bool mpm_init(fdata_t *f, struct fdata_params *p, unsigned planner_flags)
+{
+	uint n = 2*f->fftsz;
+
+	if (!(f->norm = fdata_fft_malloc(n*sizeof(real_t))) ||
+	    !(f->c = fdata_fft_malloc((n/2+1)*sizeof(fft_complex))) ||
+	    !(f->acf = fdata_fft_malloc(n*sizeof(real_t))))
+		return false;
+	if (!(f->p = fdata_plan(f, FDATA_FFT_R2C, n, f->norm, f->c, planner_flags)) ||
+	    !(f->ip = fdata_plan(f, FDATA_FFT_C2R, n, f->c, f->acf, planner_flags)))
+		return false;
+	// Planning overwrites the arrays, and chunks are only ever converted into the first half.
+	bzero(f->norm+f->fftsz, f->fftsz*sizeof(real_t));
+	return true;
+}
+
+/*
+ * next_key_max - Find the next key maximum of the NSDF, its highest point between a positive
+ *	going zero crossing and the next negative going one
+ * @t: lag to search from, updated to the end of the key maximum's positive region
+ *
+ * The positive region around lag 0 isn't a period so is skipped, as is one cut off by the
+ * last lag, whose peak might be past it. Return the lag of the key maximum, or 0 if there
+ * are no more.
+ */
+static uint next_key_max(const real_t *nsdf, uint nlags, uint *t)
+{
+	uint i = *t, maxi;
+
+	while (i < nlags && nsdf[i] > 0)
+		++i;
+	while (i < nlags && nsdf[i] <= 0)
+		++i;
+	for (maxi = i; i < nlags && nsdf[i] > 0; ++i) {
+		if (nsdf[i] > nsdf[maxi])
+			maxi = i;
+	}
+	*t = i;
+	return i < nlags ? maxi : 0;
+}
+
+static double mpm_estimate(fdata_t *f, struct timespec *last)
+{
+	uint n = f->fftsz, nlags = n*MPM_MAX_LAG, t, k;
+	real_t *x = f->norm, *nsdf = f->acf;
+	// FFTW's inverse FFT isn't normalised, so is 2n times the autocorrelation.
+	double m = 0, scale = 1.0/(2*n);
+	real_t highest = 0;
+
+	FFTW(execute_dft_r2c)(f->p, f->norm, f->c);
+	fdata_stage_time(f, FDATA_STAGE_FFT, last);
+	// The autocorrelation is the inverse FFT of the power spectrum.
+	for (uint i = 0; i <= n; ++i) {
+		f->c[i][0] = f->c[i][0]*f->c[i][0] + f->c[i][1]*f->c[i][1];
+		f->c[i][1] = 0;
+	}
+	fdata_stage_time(f, FDATA_STAGE_MAGNITUDES, last);
+	FFTW(execute_dft_c2r)(f->ip, f->c, f->acf);
+	fdata_stage_time(f, FDATA_STAGE_FFT, last);
+
+	// The NSDF at lag t is 2r(t)/m(t), where r is the autocorrelation and m(t) the sum of
+	// squares of the samples that overlap at lag t, which drops the squares of the samples at
+	// both ends of the chunk as the lag grows.
+	for (uint i = 0; i < n; ++i)
+		m += x[i]*x[i];
+	m *= 2;
+	for (t = 0; t < nlags; ++t) {
+		nsdf[t] = m > 0 ? 2*nsdf[t]*scale/m : 0;
+		m -= x[t]*x[t] + x[n-1-t]*x[n-1-t];
+	}
+	fdata_stage_time(f, FDATA_STAGE_NSDF, last);
+
+	t = 0;
+	while ((k = next_key_max(nsdf, nlags, &t)))
+		highest = nsdf[k] > highest ? nsdf[k] : highest;
+	if (highest < MPM_MIN_CLARITY) {
+		f->peak = 0;
+		fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+		return 0;
+	}
+	t = 0;
+	while ((k = next_key_max(nsdf, nlags, &t)) && nsdf[k] < MPM_K*highest)
+		;
+	// The key maximum is never at the first or last lag, so has neighbours either side.
+	m = k + parabolic_offset(nsdf[k-1], nsdf[k], nsdf[k+1]);
+	f->peak = nsdf[k];
+	fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+
+	return f->sample_rate/(double)f->decim/m;
+}
+
+const struct fdata_estimator fdata_estimator_mpm = {
+	.name = "mpm",
+	.windowed = false,
+	.init = mpm_init,
+	.estimate = mpm_estimate
+};
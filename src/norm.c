@@ -5,87 +5,113 @@
  */
 #include "norm.h"
 
-// Maximum size of a sample is 8 bytes, i.e. the
-// typical size of a double.
-#define MAX_SAMPLE_SZ 8
-
 /*
- * Get the best sample in an array of samples, where the "best" sample is determined
- * by the comparison function.
- * @samples: the array of samples
- * @samplesz: the size of a sample in bytes
- * @n: the number of samples in the array
- * @out_max: where to store the max sample. This should be of size samplesz
- * @cmp: comparison function comparing whether its first param is better than
- *	its second
+ * Functions specialised to a sample's numeric data type, so that the loops over samples
+ * have no per sample indirect calls and can be vectorised by the compiler.
+ * @min_max: get the min and max of an array of samples in a single pass
+ * @normalise: normalise samples into range -1 to 1 given their min and max, and multiply
+ *	them by a window if it isn't NULL, in a single pass
+ * @copy: convert samples to reals, multiplied by a window if it isn't NULL
  */
-static void best_sample(char *samples, uint samplesz, uint n, char *out_best,
-			bool (*cmp)(void *, void *))
-{
-	memcpy(out_best, samples, samplesz);
-	samples += samplesz;
-	while (--n) {
-		if (cmp(samples, out_best))
-			memcpy(out_best, samples, samplesz);
-		samples += samplesz;
-	}
-}
+struct sdtype_fns {
+	void (*min_max)(const char *samples, uint n, double *min_samp, double *max_samp);
+	void (*normalise)(const char *samples, uint n, double min_samp, double max_samp,
+			  const real_t *window, real_t *norm);
+	void (*copy)(const char *samples, uint n, const real_t *window, real_t *norm);
+};
 
 /*
- * Get the max sample in an array of samples.
- * @gt: function to compare whether a sample is greater than another sample
+ * Generate the min_max and normalise functions of a numeric type, named after the type
+ * with prefixes min_max_ and normalise_.
+ *
+ * Normalising moves a sample from the min-max range of the samples into the range -1 to 1,
+ * so that the min sample gets normalised value -1 and the max gets 1.
  */
-static void max_sample(char *samples, uint samplesz, uint n, char *out_max, 
-		       bool (*gt)(void *, void *))
-{
-	best_sample(samples, samplesz, n, out_max, gt);
+#define SDTYPE_NORM_FNS(name, type) \
+static void min_max_##name(const char *samples, uint n, double *min_samp, double *max_samp) \
+{ \
+	const type *s = (const type *)samples; \
+	type min = s[0], max = s[0]; \
+\
+	for (uint i = 1; i < n; ++i) { \
+		if (s[i] < min) \
+			min = s[i]; \
+		if (s[i] > max) \
+			max = s[i]; \
+	} \
+	*min_samp = min; \
+	*max_samp = max; \
+} \
+\
+static void normalise_##name(const char *samples, uint n, double min_samp, double max_samp, \
+			     const real_t *window, real_t *norm) \
+{ \
+	const type *s = (const type *)samples; \
+	double scale = 2/(max_samp-min_samp); \
+\
+	if (window) { \
+		for (uint i = 0; i < n; ++i) \
+			norm[i] = (real_t)((s[i]-min_samp)*scale-1)*window[i]; \
+	} else { \
+		for (uint i = 0; i < n; ++i) \
+			norm[i] = (s[i]-min_samp)*scale-1; \
+	} \
 }
 
 /*
- * Get the min sample in an array of samples.
- * @lt: function to compare whether a sample is less than another sample
+ * Generate the copy function of a numeric type without a conversion kernel, named after
+ * the type with prefix copy_.
  */
-static void min_sample(char *samples, uint samplesz, uint n, char *out_min, 
-		       bool (*lt)(void *, void *))
+#define SDTYPE_COPY_FN(name, type) \
+static void copy_##name(const char *samples, uint n, const real_t *window, real_t *norm) \
+{ \
+	const type *s = (const type *)samples; \
+\
+	if (window) { \
+		for (uint i = 0; i < n; ++i) \
+			norm[i] = (real_t)s[i]*window[i]; \
+	} else { \
+		for (uint i = 0; i < n; ++i) \
+			norm[i] = s[i]; \
+	} \
+}
+
+SDTYPE_NORM_FNS(float,  float)
+SDTYPE_NORM_FNS(double, double)
+SDTYPE_NORM_FNS(short,  short)
+SDTYPE_NORM_FNS(int,    int)
+SDTYPE_NORM_FNS(ushort, unsigned short)
+SDTYPE_NORM_FNS(uint,   unsigned int)
+
+SDTYPE_COPY_FN(double, double)
+SDTYPE_COPY_FN(ushort, unsigned short)
+SDTYPE_COPY_FN(uint,   unsigned int)
+
+// The formats samples are captured in have conversion kernels.
+static void copy_float(const char *samples, uint n, const real_t *window, real_t *norm)
 {
-	best_sample(samples, samplesz, n, out_min, lt);
+	kern->convert_f32((const float *)samples, window, norm, n);
 }
 
-static bool lt_float(void *a, void *b)  { return *(float *)a < *(float *)b; }
-static bool gt_float(void *a, void *b)  { return *(float *)a > *(float *)b; }
-static bool lt_double(void *a, void *b) { return *(double *)a < *(double *)b; }
-static bool gt_double(void *a, void *b) { return *(double *)a > *(double *)b; }
-static bool lt_short(void *a, void *b)  { return *(short *)a < *(short *)b; }
-static bool gt_short(void *a, void *b)  { return *(short *)a > *(short *)b; }
-static bool lt_int(void *a, void *b)    { return *(int *)a < *(int *)b; }
-static bool gt_int(void *a, void *b)    { return *(int *)a > *(int *)b; }
-static bool lt_ushort(void *a, void *b) { return *(unsigned short *)a < *(unsigned short *)b; }
-static bool gt_ushort(void *a, void *b) { return *(unsigned short *)a > *(unsigned short *)b; }
-static bool lt_uint(void *a, void *b)   { return *(unsigned int *)a < *(unsigned int *)b; }
-static bool gt_uint(void *a, void *b)   { return *(unsigned int *)a > *(unsigned int *)b; }
-
-static double ftod(void *p)  { return *(float *)p; }
-static double dtod(void *p)  { return *(double *)p; }
-static double stod(void *p)  { return *(short *)p; }
-static double itod(void *p)  { return *(int *)p; }
-static double ustod(void *p) { return *(unsigned short *)p; }
-static double uitod(void *p) { return *(unsigned int *)p; }
+static void copy_short(const char *samples, uint n, const real_t *window, real_t *norm)
+{
+	kern->convert_s16((const int16_t *)samples, window, norm, n);
+}
 
-struct sdtype_fns {
-	bool (*lt)(void *, void *);  // Less than.
-	bool (*gt)(void *, void *);  // Greater than.
-	double (*xtod)(void *);  // Convert a numeric type to a double.
-};
+static void copy_int(const char *samples, uint n, const real_t *window, real_t *norm)
+{
+	kern->convert_s32((const int32_t *)samples, window, norm, n);
+}
 
-static struct sdtype_fns float_fns  = { lt_float,  gt_float,  ftod };
-static struct sdtype_fns double_fns = { lt_double, gt_double, dtod };
-static struct sdtype_fns short_fns  = { lt_short,  gt_short,  stod };
-static struct sdtype_fns int_fns    = { lt_int,    gt_int,    itod };
-static struct sdtype_fns ushort_fns = { lt_ushort, gt_ushort, ustod };
-static struct sdtype_fns uint_fns   = { lt_uint,   gt_uint,   uitod };
+static struct sdtype_fns float_fns  = { min_max_float,  normalise_float,  copy_float };
+static struct sdtype_fns double_fns = { min_max_double, normalise_double, copy_double };
+static struct sdtype_fns short_fns  = { min_max_short,  normalise_short,  copy_short };
+static struct sdtype_fns int_fns    = { min_max_int,    normalise_int,    copy_int };
+static struct sdtype_fns ushort_fns = { min_max_ushort, normalise_ushort, copy_ushort };
+static struct sdtype_fns uint_fns   = { min_max_uint,   normalise_uint,   copy_uint };
 
 /*
- * Select comparison and conversion functions dependent on a sample's numeric data type.
+ * Select the functions specialised to a sample's numeric data type.
  */
 static struct sdtype_fns *select_sdtype_fns(sdtype_number_type type)
 {
@@ -100,58 +126,56 @@ static struct sdtype_fns *select_sdtype_fns(sdtype_number_type type)
 	return NULL;
 }
 
-/*
- * normalise - Move a number from its current min-max range into a range with min -1 and
- *	max 1 (range of the new normalised number)
- * @n: number to normalise
- * @min: minimum in range number is a part of
- * @max: maximum in range number is a part of
- *
- * The min number in the original range gets normalised value -1, and the max number
- * gets 1.
- */
-static double normalise(double n, double min, double max)
-{
-	return nr_new_range(n, min, max, -1, 1);
-}
-
-void normalise_samples(char *samples, uint n, sdtype_meta_t *meta, double *norm)
+void normalise_samples(char *samples, uint n, sdtype_meta_t *meta, real_t *norm)
 {
-	char min_samp_bytes[MAX_SAMPLE_SZ];
-	char max_samp_bytes[MAX_SAMPLE_SZ];
 	struct sdtype_fns *fns = select_sdtype_fns(meta->number_type);
 	double min_samp, max_samp;
 
-	bzero(min_samp_bytes, sizeof(min_samp_bytes));
-	bzero(max_samp_bytes, sizeof(max_samp_bytes));
+	fns->min_max(samples, n, &min_samp, &max_samp);
+	fns->normalise(samples, n, min_samp, max_samp, NULL, norm);
+}
 
-	min_sample(samples, meta->samplesz, n, min_samp_bytes, fns->lt);
-	max_sample(samples, meta->samplesz, n, max_samp_bytes, fns->gt);
-	min_samp = fns->xtod(min_samp_bytes);
-	max_samp = fns->xtod(max_samp_bytes);
+void normalise_samples_copy(char *samples, uint n, sdtype_meta_t *meta, real_t *norm)
+{
+	select_sdtype_fns(meta->number_type)->copy(samples, n, NULL, norm);
+}
 
-	for (; n--; ++norm) {
-		*norm = normalise(fns->xtod(samples), min_samp, max_samp);
-		samples += meta->samplesz;
+void normalise_samples_ring(char *samples, uint n, uint start, sdtype_meta_t *meta,
+			    const real_t *window, real_t *norm)
+{
+	struct sdtype_fns *fns = select_sdtype_fns(meta->number_type);
+	char *oldest = samples+start*meta->samplesz;
+	uint noldest = n-start;
+	double min_samp, max_samp, min_newest, max_newest;
+
+	fns->min_max(oldest, noldest, &min_samp, &max_samp);
+	if (start) {
+		fns->min_max(samples, start, &min_newest, &max_newest);
+		min_samp = fmin(min_samp, min_newest);
+		max_samp = fmax(max_samp, max_newest);
 	}
+	fns->normalise(oldest, noldest, min_samp, max_samp, window, norm);
+	fns->normalise(samples, start, min_samp, max_samp, window ? window+noldest : NULL,
+		       norm+noldest);
 }
 
-void normalise_samples_copy(char *samples, uint n, sdtype_meta_t *meta, double *norm)
+void normalise_samples_copy_ring(char *samples, uint n, uint start, sdtype_meta_t *meta,
+				 const real_t *window, real_t *norm)
 {
 	struct sdtype_fns *fns = select_sdtype_fns(meta->number_type);
+	uint noldest = n-start;
 
-	for (; n--; ++norm) {
-		*norm = fns->xtod(samples);
-		samples += meta->samplesz;
-	}
+	fns->copy(samples+start*meta->samplesz, noldest, window, norm);
+	fns->copy(samples, start, window ? window+noldest : NULL, norm+noldest);
 }
 
-sdtype_meta_t sdtype_meta_float32  = { SDTYPE_FLOAT,  sizeof(float) };
-sdtype_meta_t sdtype_meta_double64 = { SDTYPE_DOUBLE, sizeof(double) };
-sdtype_meta_t sdtype_meta_int16    = { SDTYPE_SHORT,  sizeof(short) };
-sdtype_meta_t sdtype_meta_int32    = { SDTYPE_INT,    sizeof(int) };
-sdtype_meta_t sdtype_meta_uint16   = { SDTYPE_USHORT, sizeof(unsigned short) };
-sdtype_meta_t sdtype_meta_uint32   = { SDTYPE_UINT,   sizeof(unsigned int) };
+sdtype_meta_t sdtype_meta_float32  = { SDTYPE_FLOAT,  sizeof(float),          1 };
+sdtype_meta_t sdtype_meta_double64 = { SDTYPE_DOUBLE, sizeof(double),         1 };
+sdtype_meta_t sdtype_meta_int16    = { SDTYPE_SHORT,  sizeof(short),          SHRT_MAX+1.0 };
+sdtype_meta_t sdtype_meta_int32    = { SDTYPE_INT,    sizeof(int),            INT_MAX+1.0 };
+// Unsigned samples are copied as they are, so swing by half their range about its middle.
+sdtype_meta_t sdtype_meta_uint16   = { SDTYPE_USHORT, sizeof(unsigned short), SHRT_MAX+1.0 };
+sdtype_meta_t sdtype_meta_uint32   = { SDTYPE_UINT,   sizeof(unsigned int),   INT_MAX+1.0 };
 
 void norm_assert(void)
 {
@@ -165,7 +189,5 @@ void norm_assert(void)
 	assert(sdtype_meta_int32.samplesz    == 4);
 	assert(sdtype_meta_uint16.samplesz   == 2);
 	assert(sdtype_meta_uint32.samplesz   == 4);
-
-	assert(MAX_SAMPLE_SZ == sizeof(double));
 }
 
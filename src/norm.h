@@ -12,6 +12,7 @@
 #include <limits.h>
 #include <sys/types.h>
 #include "math.h"
+#include "kern.h"
 
 typedef enum {
 	SDTYPE_FLOAT,
@@ -28,6 +29,7 @@ typedef enum {
 struct sample_data_type_metadata {
 	sdtype_number_type number_type;
 	uint samplesz;  // Size of a sample in bytes.
+	double full_scale;  // Largest magnitude of a sample, which copied samples are relative to.
 };
 
 typedef struct sample_data_type_metadata sdtype_meta_t;
@@ -48,11 +50,31 @@ extern sdtype_meta_t sdtype_meta_uint32;
  * @norm: out-param array where to store normalised samples. This should be the 
  *	same length as the samples array.
  */
-void normalise_samples(char *samples, uint n, sdtype_meta_t *meta, double *norm);
+void normalise_samples(char *samples, uint n, sdtype_meta_t *meta, real_t *norm);
 /*
  * Copy the samples directly to the normalised array.
  */
-void normalise_samples_copy(char *samples, uint n, sdtype_meta_t *meta, double *norm);
+void normalise_samples_copy(char *samples, uint n, sdtype_meta_t *meta, real_t *norm);
+
+/*
+ * Normalise audio samples stored in a circular buffer, as with normalise_samples(), and
+ * run a window on them in the same pass.
+ * @samples: circular buffer of samples
+ * @n: number of samples in the circular buffer
+ * @start: index of the oldest sample in the circular buffer
+ * @window: n window coefficients to multiply the normalised samples by, or NULL for none
+ *
+ * The normalised samples are stored oldest first, so the two wrapped segments of the
+ * circular buffer are unrolled into the norm array without first copying them.
+ */
+void normalise_samples_ring(char *samples, uint n, uint start, sdtype_meta_t *meta,
+			    const real_t *window, real_t *norm);
+/*
+ * Copy samples stored in a circular buffer directly to the normalised array, oldest first,
+ * multiplied by the window unless it's NULL.
+ */
+void normalise_samples_copy_ring(char *samples, uint n, uint start, sdtype_meta_t *meta,
+				 const real_t *window, real_t *norm);
 
 /*
  * Assert that the normalise functions can be used on this machine.
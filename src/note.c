@@ -3,7 +3,9 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#include <errno.h>
 #include "note.h"
+#include "err.h"
 
 // Frequency (in Hz) of base note A4.
 #define BASE_NOTE_FREQ 440 
@@ -11,7 +13,14 @@
 // Frequency (in Hz) of the first note C0.
 #define FIRST_NOTE_FREQ 16.35
 
+// Semitones of A4 above C0.
+#define BASE_NOTE_SEMITONES (BASE_NOTE_NR*NNOTES + 9)
+
 static const char *NOTES[] = { "A", "A#", "B", "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#" };
+// Names of notes from C, each a letter and whether it's sharp.
+static const char NAMES[NNOTES][2] = {
+	"C ", "C#", "D ", "D#", "E ", "F ", "F#", "G ", "G#", "A ", "A#", "B "
+};
 
 /*
  * semitones_from_note - Get the number of semitones a note is away from another note
@@ -79,3 +88,71 @@ void note_from_freq(double freq, char *s)
 	*s = '0'+note_nr;  // Append its number.
 }
 
+
+double note_semitones(double freq)
+{
+	return semitones_from_base(freq) + BASE_NOTE_SEMITONES;
+}
+
+/*
+ * note_from_semitones - Get the note nearest to a number of semitones above C0
+ */
+static void note_from_semitones(double semitones, struct note *n)
+{
+	long k = lround(semitones);
+
+	n->index = (k%NNOTES + NNOTES)%NNOTES;
+	n->octave = (k - n->index)/NNOTES;
+	n->cents = 100*(semitones - k);
+}
+
+void note_nearest(double freq, struct note *n)
+{
+	note_from_semitones(note_semitones(freq), n);
+}
+
+void note_name(const struct note *n, char *s)
+{
+	s[0] = NAMES[n->index][0];
+	if (NAMES[n->index][1] == '#') {
+		s[1] = '#';
+		s[2] = '0'+n->octave;
+	} else {
+		s[1] = '0'+n->octave;
+		s[2] = ' ';
+	}
+}
+
+bool note_table_init(note_table_t *t, double min_freq, double max_freq, double step)
+{
+	t->step = step;
+	// There are no semitones of 0 Hz.
+	t->first = floor(min_freq/step) > 1 ? floor(min_freq/step) : 1;
+	// An entry past max_freq for interpolating up to it.
+	t->n = ceil(max_freq/step) - t->first + 2;
+	if (!(t->semitones = malloc(t->n*sizeof(float)))) {
+		eprintf("failed to allocate note table: %s", strerror(errno));
+		return false;
+	}
+	for (uint i = 0; i < t->n; ++i)
+		t->semitones[i] = note_semitones((t->first+i)*step);
+	return true;
+}
+
+void note_table_free(note_table_t *t)
+{
+	free(t->semitones);
+}
+
+void note_table_lookup(note_table_t *t, double freq, struct note *n)
+{
+	double x = freq/t->step - t->first;
+	uint i;
+
+	if (!(x >= 0 && x < t->n-1)) {
+		note_nearest(freq, n);
+		return;
+	}
+	i = x;
+	note_from_semitones(t->semitones[i] + (t->semitones[i+1]-t->semitones[i])*(x-i), n);
+}
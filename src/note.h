@@ -12,12 +12,38 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <sys/types.h>
 
 // Highest note allowed is something around E6, so not bothering with handling
 // notes with numbers >= 10.
 #define MAX_NOTE_LEN 3
 #define NNOTES 12  
 
+// Entries of a note table per bin of the FFT of a chunk, so that frequencies interpolated
+// between bins are looked up within a tenth of a cent from bin 6 up.
+#define NOTE_TABLE_STEPS 8
+
+// A note of equal temperament with A4 at 440 Hz, and how far a frequency is from it.
+struct note {
+	int index;  // Semitones of the note above C, 0 for C to 11 for B.
+	int octave;  // The 4 in A4.
+	double cents;  // Cents the frequency is sharp (positive) or flat of the note, -50 to 50.
+};
+
+/*
+ * Table of notes of frequencies evenly spaced from min_freq up, so that the note of a
+ * frequency is found without logarithms.
+ */
+struct note_table {
+	double step;  // Frequency between entries.
+	double first;  // Number of steps from 0 Hz of the first entry.
+	uint n;  // Number of entries.
+	float *semitones;  // Semitones of the frequency of each entry above C0, see note_semitones().
+};
+
+typedef struct note_table note_table_t;
+
 /*
  * Initialise a string storing a musical note by filling it with spaces so that
  * its displayed width becomes MAX_NOTE_LEN. If it were filled with null termination characters
@@ -32,4 +58,44 @@ void init_note(char *note);
  */
 void note_from_freq(double freq, char *s);
 
+/*
+ * note_semitones - Get the number of semitones a frequency is above C0, fractional if it's
+ *	between notes
+ */
+double note_semitones(double freq);
+
+/*
+ * note_nearest - Get the note nearest to a frequency, and how far the frequency is from it
+ */
+void note_nearest(double freq, struct note *n);
+
+/*
+ * note_name - Get the name of a note, the same as note_from_freq() gives for its frequency
+ * @s: string to store note name in. Must have length of at least MAX_NOTE_LEN
+ */
+void note_name(const struct note *n, char *s);
+
+/*
+ * note_table_init - Initialise a table of the notes of frequencies in a range
+ * @min_freq: lowest frequency of the table
+ * @max_freq: highest frequency of the table
+ * @step: frequency between entries, a bin of the FFT of a chunk over NOTE_TABLE_STEPS for
+ *	its entries to fall on the bins and evenly between them
+ *
+ * Return false if the table couldn't be allocated.
+ */
+bool note_table_init(note_table_t *t, double min_freq, double max_freq, double step);
+
+void note_table_free(note_table_t *t);
+
+/*
+ * note_table_lookup - Get the note nearest to a frequency, and how far the frequency is from
+ *	it, from a note table
+ *
+ * The semitones of frequencies between entries are interpolated from those of the entries
+ * either side. Frequencies outside the table are still looked up, the slow way with
+ * note_nearest().
+ */
+void note_table_lookup(note_table_t *t, double freq, struct note *n);
+
 #endif
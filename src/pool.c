@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "pool.h"
+
+/*
+ * pool_work - Take and run jobs of the current batch until there are none left
+ *
+ * Called and returns with the pool's lock held, which is released while running a job.
+ */
+static void pool_work(pool_t *p)
+{
+	uint i;
+
+	while (p->next < p->njobs) {
+		i = p->next++;
+		pthread_mutex_unlock(&p->lock);
+		p->fn(p->arg, i);
+		pthread_mutex_lock(&p->lock);
+		if (++p->nfinished == p->njobs)
+			pthread_cond_signal(&p->done);
+	}
+}
+
+static void *pool_worker(void *data)
+{
+	pool_t *p = data;
+	uint64_t seen = 0;
+
+	pthread_mutex_lock(&p->lock);
+	for (;;) {
+		while (!p->stop && p->batch == seen)
+			pthread_cond_wait(&p->start, &p->lock);
+		if (p->stop)
+			break;
+		seen = p->batch;
+		pool_work(p);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+bool pool_init(pool_t *p, uint nthreads)
+{
+	int err;
+
+	bzero(p, sizeof(pool_t));
+	if (nthreads && !(p->threads = malloc(nthreads*sizeof(pthread_t)))) {
+		eprintf("failed to allocate worker threads: %s", strerror(errno));
+		return false;
+	}
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->start, NULL);
+	pthread_cond_init(&p->done, NULL);
+	for (; p->nthreads < nthreads; ++p->nthreads) {
+		if ((err = pthread_create(&p->threads[p->nthreads], NULL, pool_worker, p)) != 0) {
+			eprintf("failed to start worker thread: %s", strerror(err));
+			pool_free(p);
+			return false;
+		}
+	}
+	return true;
+}
+
+void pool_run(pool_t *p, pool_fn fn, void *arg, uint njobs)
+{
+	pthread_mutex_lock(&p->lock);
+	p->fn = fn;
+	p->arg = arg;
+	p->njobs = njobs;
+	p->next = 0;
+	p->nfinished = 0;
+	++p->batch;
+	if (p->nthreads)
+		pthread_cond_broadcast(&p->start);
+	pool_work(p);
+	while (p->nfinished < p->njobs)
+		pthread_cond_wait(&p->done, &p->lock);
+	pthread_mutex_unlock(&p->lock);
+}
+
+void pool_free(pool_t *p)
+{
+	if (p) {
+		pthread_mutex_lock(&p->lock);
+		p->stop = true;
+		pthread_cond_broadcast(&p->start);
+		pthread_mutex_unlock(&p->lock);
+		for (uint i = 0; i < p->nthreads; ++i)
+			pthread_join(p->threads[i], NULL);
+		pthread_cond_destroy(&p->done);
+		pthread_cond_destroy(&p->start);
+		pthread_mutex_destroy(&p->lock);
+		free(p->threads);
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Pool of worker threads that run a batch of independent jobs in parallel, such as
+ * processing each channel of a multi-channel source. The thread that starts a batch works
+ * on it too, and waits for it to finish, so a batch takes as long as its slowest job when
+ * there are as many threads as jobs.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "err.h"
+
+typedef void (*pool_fn)(void *arg, uint i);
+
+struct worker_pool {
+	pthread_t *threads;
+	uint nthreads;
+	pthread_mutex_t lock;  // Guards everything below.
+	pthread_cond_t start;  // Signalled when a batch starts or the pool is stopping.
+	pthread_cond_t done;  // Signalled when the last job of a batch finishes.
+	uint64_t batch;  // Number of batches started, so a worker can tell a new one has.
+	pool_fn fn;
+	void *arg;
+	uint njobs;
+	uint next;  // Index of the next job of the batch for a thread to take.
+	uint nfinished;  // Number of jobs of the batch finished.
+	bool stop;
+};
+
+typedef struct worker_pool pool_t;
+
+/*
+ * pool_init - Initialise a pool and start its worker threads
+ * @nthreads: number of worker threads, which can be 0 to run every job on the thread
+ *	that starts a batch
+ *
+ * Return whether the initialisation was successful. Free with pool_free().
+ */
+bool pool_init(pool_t *p, uint nthreads);
+
+/*
+ * pool_run - Run a batch of jobs on the pool and wait for them all to finish
+ * @fn: function run for each job, given arg and the index of the job
+ * @njobs: number of jobs, run as fn(arg, 0) to fn(arg, njobs-1)
+ *
+ * Only one thread may run batches on a pool.
+ */
+void pool_run(pool_t *p, pool_fn fn, void *arg, uint njobs);
+
+/*
+ * pool_free - Stop a pool's worker threads and free a pool initialised with pool_init
+ */
+void pool_free(pool_t *p);
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "pub.h"
+
+/*
+ * pub_map - Map a publication file's page
+ * @prot: PROT_READ for a reader, or with PROT_WRITE for the writer
+ */
+static bool pub_map(pub_t *p, const char *path, int prot)
+{
+	p->page = mmap(NULL, sizeof(struct pub_page), prot, MAP_SHARED, p->fd, 0);
+	if (p->page == MAP_FAILED) {
+		eprintf("failed to map publication file %s: %s", path, strerror(errno));
+		close(p->fd);
+		return false;
+	}
+	return true;
+}
+
+bool pub_init(pub_t *p, const char *path)
+{
+	if ((p->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0) {
+		eprintf("failed to open publication file %s: %s", path, strerror(errno));
+		return false;
+	}
+	// Truncate to nothing first, so that a snapshot of an earlier run is never read as this one's.
+	if (ftruncate(p->fd, 0) != 0 || ftruncate(p->fd, sizeof(struct pub_page)) != 0) {
+		eprintf("failed to size publication file %s: %s", path, strerror(errno));
+		close(p->fd);
+		return false;
+	}
+	if (!pub_map(p, path, PROT_READ | PROT_WRITE))
+		return false;
+	p->page->magic = PUB_MAGIC;
+	p->page->version = PUB_VERSION;
+	return true;
+}
+
+void pub_free(pub_t *p)
+{
+	if (p && p->page) {
+		munmap(p->page, sizeof(struct pub_page));
+		close(p->fd);
+		p->page = NULL;
+	}
+}
+
+void pub_publish(pub_t *p, const struct pub_snapshot *s)
+{
+	struct pub_page *pg = p->page;
+	uint64_t words[PUB_NWORDS];
+	uint64_t seq = atomic_load_explicit(&pg->seq, memory_order_relaxed);
+
+	memcpy(words, s, sizeof(words));
+	atomic_store_explicit(&pg->seq, seq+1, memory_order_relaxed);
+	// Keep the words from being written before the sequence number is seen to be odd.
+	atomic_thread_fence(memory_order_release);
+	for (size_t i = 0; i < PUB_NWORDS; ++i)
+		atomic_store_explicit(&pg->words[i], words[i], memory_order_relaxed);
+	atomic_store_explicit(&pg->seq, seq+2, memory_order_release);
+}
+
+bool pub_open(pub_t *p, const char *path)
+{
+	struct stat st;
+
+	if ((p->fd = open(path, O_RDONLY)) < 0) {
+		eprintf("failed to open publication file %s: %s", path, strerror(errno));
+		return false;
+	}
+	if (fstat(p->fd, &st) != 0 || st.st_size < sizeof(struct pub_page)) {
+		eprintf("%s isn't a publication file", path);
+		close(p->fd);
+		return false;
+	}
+	if (!pub_map(p, path, PROT_READ))
+		return false;
+	if (p->page->magic != PUB_MAGIC || p->page->version != PUB_VERSION) {
+		eprintf("%s isn't a publication file of version %d", path, PUB_VERSION);
+		pub_free(p);
+		return false;
+	}
+	return true;
+}
+
+bool pub_read(pub_t *p, struct pub_snapshot *s)
+{
+	struct pub_page *pg = p->page;
+	uint64_t words[PUB_NWORDS];
+	uint64_t seq;
+
+	for (;;) {
+		seq = atomic_load_explicit(&pg->seq, memory_order_acquire);
+		if (seq == 0)
+			return false;
+		if (seq & 1)
+			continue;
+		for (size_t i = 0; i < PUB_NWORDS; ++i)
+			words[i] = atomic_load_explicit(&pg->words[i], memory_order_relaxed);
+		// Keep the words from being read after the sequence number is checked again.
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&pg->seq, memory_order_relaxed) == seq)
+			break;
+	}
+	memcpy(s, words, sizeof(words));
+	return true;
+}
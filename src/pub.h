@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Publication of a tuner's latest pitch in a memory mapped file, such as one in /dev/shm, for
+ * any number of other processes on the machine to sample whenever they like. The file is
+ * guarded by a seqlock: the tuner bumps a sequence number to odd before writing the latest
+ * pitch and back to even after, and a reader copies the pitch out between two reads of an
+ * even and unchanged sequence number, trying again if it changed. Neither side makes a system
+ * call or waits on the other, so readers never hold up processing, however many or slow.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef PUB_H
+#define PUB_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "err.h"
+
+// "GTUN", the first word of a publication file, for readers to check they've mapped one.
+#define PUB_MAGIC 0x4e555447u
+// Bumped whenever the layout of struct pub_page changes.
+#define PUB_VERSION 1
+// Most channels of a source whose pitch is published.
+#define PUB_MAX_CHANNELS 32
+
+struct pub_channel {
+	double freq;  // Frequency of the last chunk, 0 if none was found.
+	double cents;  // Cents the frequency is sharp (positive) or flat of the note, 0 if none.
+	double peak;  // Strength of the peak the frequency was found from, see fdata_t.
+	int32_t note;  // Semitones of the note above C, -1 if the frequency isn't a valid note.
+	int32_t octave;  // 0 if the frequency isn't a valid note.
+};
+
+// The latest pitch of every channel of a tuner, as of a hop.
+struct pub_snapshot {
+	uint64_t hop;  // Number of hops published so far, so readers can tell new ones apart.
+	uint64_t sample;  // Number of frames read from the source up to the end of the chunk.
+	int64_t read_ns;  // Wall clock time the end of the chunk was read, ns since the Unix epoch.
+	uint32_t sample_rate;
+	uint32_t nchannels;
+	struct pub_channel channels[PUB_MAX_CHANNELS];
+};
+
+#define PUB_NWORDS (sizeof(struct pub_snapshot)/sizeof(uint64_t))
+
+/*
+ * The contents of a publication file. The snapshot is copied in and out a word at a time
+ * with relaxed atomics, so that a read racing a write is only ever torn, never undefined, and
+ * the sequence number tells the reader to discard it.
+ */
+struct pub_page {
+	uint32_t magic;
+	uint32_t version;
+	// Even when the snapshot is whole, odd while it's being written, 0 if nothing's published.
+	// On a cache line of its own, apart from the header readers only read once.
+	_Alignas(64) atomic_uint_least64_t seq;
+	atomic_uint_least64_t words[PUB_NWORDS];
+};
+
+_Static_assert(sizeof(struct pub_snapshot) % sizeof(uint64_t) == 0,
+	       "snapshots must be a whole number of words");
+
+struct publication {
+	struct pub_page *page;
+	int fd;
+};
+
+typedef struct publication pub_t;
+
+/*
+ * pub_init - Create a publication file, or truncate one of an earlier run, and map it
+ * @path: file to publish in. One in /dev/shm is only ever in memory
+ *
+ * Return whether the initialisation was successful. Free with pub_free().
+ */
+bool pub_init(pub_t *p, const char *path);
+
+/*
+ * pub_free - Unmap a publication file, which stays for readers to still read the last pitch
+ */
+void pub_free(pub_t *p);
+
+/*
+ * pub_publish - Publish a snapshot, never waiting on readers (only one writer)
+ */
+void pub_publish(pub_t *p, const struct pub_snapshot *s);
+
+/*
+ * pub_open - Map a publication file read only, for reading with pub_read()
+ *
+ * Return false if it couldn't be mapped or isn't a publication file of this version.
+ */
+bool pub_open(pub_t *p, const char *path);
+
+/*
+ * pub_read - Copy out the latest published snapshot without a system call
+ *
+ * Tries again while a snapshot is being written. Return false if nothing's been published yet.
+ */
+bool pub_read(pub_t *p, struct pub_snapshot *s);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "raw.h"
+
+static bool is_stdin(const char *path)
+{
+	return !path || strcmp(path, "-") == 0;
+}
+
+bool raw_open(raw_t *r, const char *path, uint framesz)
+{
+	r->framesz = framesz;
+	if (is_stdin(path)) {
+		r->fp = stdin;
+		return true;
+	}
+	if (!(r->fp = fopen(path, "rb"))) {
+		eprintf("couldn't open raw PCM file %s: %s", path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+bool raw_read(raw_t *r, char *samples, uint readsz)
+{
+	// fread() keeps reading until it gets all the samples or hits the end of the
+	// input, so a pipe that delivers less than a whole read at a time is fine.
+	return fread(samples, r->framesz, readsz, r->fp) == readsz;
+}
+
+void raw_close(raw_t *r)
+{
+	if (r && r->fp != stdin)
+		fclose(r->fp);
+}
@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Reading raw (headerless) PCM samples from a file or standard input.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef RAW_H
+#define RAW_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "err.h"
+
+struct raw_pcm {
+	FILE *fp;
+	uint framesz;  // Size of a frame (a sample of each channel) in bytes.
+};
+
+typedef struct raw_pcm raw_t;
+
+/*
+ * raw_open - Open raw PCM input
+ * @path: path to the file of samples, or NULL or "-" to read from standard input
+ * @framesz: size of a frame (a sample of each channel) in bytes
+ *
+ * The samples must be in the host's byte order, with the samples of multiple channels
+ * interleaved. Return whether the input was successfully opened. Close with raw_close().
+ */
+bool raw_open(raw_t *r, const char *path, uint framesz);
+
+/*
+ * raw_read - Read samples from raw PCM input
+ * @samples: array to store read samples into
+ * @readsz: number of frames to read
+ *
+ * Blocks until the read size amount of frames has been read. Return false at the
+ * end of the input if there weren't enough samples left to fill the read size.
+ */
+bool raw_read(raw_t *r, char *samples, uint readsz);
+
+/*
+ * raw_close - Close raw PCM input opened with raw_open
+ */
+void raw_close(raw_t *r);
+
+#endif
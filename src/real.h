@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Floating point precision of the processing pipeline, chosen at build time. Building
+ * with GTUNE_FLOAT defined (make FLOAT=1) processes samples as single-precision floats with
+ * fftw3f, otherwise as doubles with fftw3. Single precision halves the memory and cache used
+ * by the processing buffers and doubles the number of values per SIMD register, which is
+ * plenty precise for samples that are captured as 32-bit floats or smaller.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef REAL_H
+#define REAL_H
+
+#include <math.h>
+#include <fftw3.h>
+
+#ifdef GTUNE_FLOAT
+typedef float real_t;
+typedef fftwf_complex fft_complex;
+typedef fftwf_plan fft_plan;
+// Prefix a FFTW function name with that of the single-precision library.
+#define FFTW(name) fftwf_##name
+#define real_sqrt sqrtf
+#else
+typedef double real_t;
+typedef fftw_complex fft_complex;
+typedef fftw_plan fft_plan;
+#define FFTW(name) fftw_##name
+#define real_sqrt sqrt
+#endif
+
+#endif
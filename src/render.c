@@ -0,0 +1,127 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "render.h"
+
+bool render_init(render_t *r, uint nchannels, const char *label, uint fps)
+{
+	if (fps == 0) {
+		eprintf("frame rate must be at least 1");
+		return false;
+	}
+	if (!tribuf_init(&r->frames, nchannels*sizeof(struct render_note)))
+		return false;
+	if (!(r->drawn = calloc(nchannels, sizeof(struct render_note)))) {
+		eprintf("failed to allocate display: %s", strerror(errno));
+		tribuf_free(&r->frames);
+		return false;
+	}
+	r->any_drawn = false;
+	r->nchannels = nchannels;
+	r->label = label;
+	r->period_ns = 1000000000L/fps;
+	atomic_init(&r->stopping, false);
+	return true;
+}
+
+void render_free(render_t *r)
+{
+	if (r) {
+		tribuf_free(&r->frames);
+		free(r->drawn);
+	}
+}
+
+/*
+ * render_changed - Get whether the notes taken would be drawn differently to those last drawn
+ *
+ * Cents and frequencies are compared to the precision they're drawn with, so that noise in
+ * digits that aren't drawn doesn't redraw the same line.
+ */
+static bool render_changed(render_t *r, struct render_note *notes)
+{
+	if (!r->any_drawn)
+		return true;
+	for (uint c = 0; c < r->nchannels; ++c) {
+		if (memcmp(notes[c].note, r->drawn[c].note, MAX_NOTE_LEN) != 0 ||
+		    lround(notes[c].cents*10) != lround(r->drawn[c].cents*10) ||
+		    lround(notes[c].freq*1000) != lround(r->drawn[c].freq*1000))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * render_draw - Draw the latest published notes over the last drawn, if they've changed
+ *
+ * A labelled tuner shares the display with other tuners, so prints a line of its own instead.
+ */
+static void render_draw(render_t *r)
+{
+	struct render_note *n;
+
+	if (!tribuf_take(&r->frames))
+		return;
+	n = tribuf_front(&r->frames);
+	if (!render_changed(r, n))
+		return;
+	// Keep the lines of tuners drawing at the same time apart.
+	flockfile(stdout);
+	if (r->nchannels == 1 && !r->label) {
+		printf("\r%.*s        %+5.1f  %07.3f", MAX_NOTE_LEN, n->note, n->cents, n->freq);
+	} else {
+		printf(r->label ? "%s: " : "\r", r->label);
+		for (uint c = 0; c < r->nchannels; ++c)
+			printf("%s%.*s %+5.1f %07.3f", c ? " | " : "", MAX_NOTE_LEN, n[c].note,
+			       n[c].cents, n[c].freq);
+		if (r->label)
+			printf("\n");
+	}
+	fflush(stdout);
+	funlockfile(stdout);
+	memcpy(r->drawn, n, r->nchannels*sizeof(struct render_note));
+	r->any_drawn = true;
+}
+
+static void *render_thread(void *arg)
+{
+	render_t *r = arg;
+	struct timespec period = { r->period_ns/1000000000L, r->period_ns%1000000000L };
+
+	while (!atomic_load_explicit(&r->stopping, memory_order_relaxed)) {
+		render_draw(r);
+		nanosleep(&period, NULL);
+	}
+	render_draw(r);
+	return NULL;
+}
+
+bool render_start(render_t *r)
+{
+	int err;
+
+	atomic_store_explicit(&r->stopping, false, memory_order_relaxed);
+	if ((err = pthread_create(&r->thread, NULL, render_thread, r)) != 0) {
+		eprintf("failed to start display thread: %s", strerror(err));
+		return false;
+	}
+	return true;
+}
+
+void render_stop(render_t *r)
+{
+	atomic_store_explicit(&r->stopping, true, memory_order_relaxed);
+	pthread_join(r->thread, NULL);
+}
+
+struct render_note *render_frame(render_t *r)
+{
+	return tribuf_back(&r->frames);
+}
+
+void render_publish(render_t *r)
+{
+	tribuf_publish(&r->frames);
+}
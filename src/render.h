@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Live display of a tuner's notes, drawn on a thread of its own so that a slow terminal,
+ * such as a serial console or an SSH session, never holds up reading and processing the
+ * source. The processing thread publishes the notes of each hop into a triple buffer
+ * without waiting, and the display thread redraws them at most a frame rate's times a
+ * second, and only when they've changed.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/types.h>
+#include "note.h"
+#include "tribuf.h"
+#include "err.h"
+
+// The note of a channel, as displayed.
+struct render_note {
+	char note[MAX_NOTE_LEN];  // Last valid note.
+	double cents;  // Cents the last valid frequency is off the note.
+	double freq;  // Frequency of the last processed chunk.
+};
+
+struct renderer {
+	tribuf_t frames;  // The notes of every channel of each hop, the latest taken by the display.
+	struct render_note *drawn;  // Notes last drawn, so that unchanged notes aren't redrawn.
+	bool any_drawn;
+	uint nchannels;
+	const char *label;
+	long period_ns;  // Least time between redraws.
+	pthread_t thread;
+	atomic_bool stopping;
+};
+
+typedef struct renderer render_t;
+
+/*
+ * render_init - Initialise a display of the notes of a tuner
+ * @nchannels: number of channels whose notes are displayed together
+ * @label: name printed at the start of a line of notes, if it's one of several tuners each
+ *	printing lines of their own, or NULL to redraw the one line
+ * @fps: most redraws a second
+ *
+ * Return whether the initialisation was successful. Free with render_free().
+ */
+bool render_init(render_t *r, uint nchannels, const char *label, uint fps);
+
+void render_free(render_t *r);
+
+/*
+ * render_start - Start the thread drawing the display
+ *
+ * Return false if the thread couldn't be started.
+ */
+bool render_start(render_t *r);
+
+/*
+ * render_stop - Draw the last published notes and stop the thread drawing the display
+ */
+void render_stop(render_t *r);
+
+/*
+ * render_frame - Get the notes of each channel to fill in for the next redraw (processing
+ *	thread only)
+ *
+ * They're those of some earlier hop, not necessarily the last, so every channel's must be
+ * filled in.
+ */
+struct render_note *render_frame(render_t *r);
+
+/*
+ * render_publish - Hand the notes filled in to the display, never waiting for it
+ *	(processing thread only)
+ */
+void render_publish(render_t *r);
+
+#endif
@@ -0,0 +1,338 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Sliding DFT estimator of the frequency of samples, which only evaluates the DFT at the
+ * frequencies of the notes that can be found and their harmonics, rather than every bin of a
+ * chunk. Each bin is updated with each new sample, adding it and removing the sample leaving
+ * the bin's window, so a hop only costs the new samples times the number of bins, however
+ * large the chunk and however many steps it's processed in.
+ *
+ * Bins are a semitone apart, so a window of the same length for all of them would either be
+ * too short to tell low notes apart or needlessly long for high ones. Instead each bin's
+ * window is the same number of periods of its note (a constant Q), so that the bins of the
+ * notes either side are well inside its main lobe, for interpolating the frequency of a note
+ * between the bins, and a harmonic a little off a note's bin is still picked up by it.
+ *
+ * A sliding DFT can't window its samples, since each sample would need a different weight
+ * for every position it passes through in the window. A Hann window is run in the frequency
+ * domain instead, from the DFTs at the bins a DFT bin either side of a note's, so each note
+ * slides 3 DFTs.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "freq.h"
+
+// Number of periods of a bin's note in its window. Its main lobe is then 2*12/SDFT_PERIODS
+// semitones wide either side (to a first approximation), and the bin takes as long to fill.
+#define SDFT_PERIODS 8
+// Note number and frequency of A4, which the other notes are tuned relative to.
+#define A4_NOTE 69
+#define A4_FREQ 440.0
+// Amplitude of a note below which there's taken to be no note, about -80 dBFS.
+#define SDFT_SILENCE 1e-4
+
+// The DFT below a note's, at it, and above it, a DFT bin apart.
+#define NDFTS 3
+
+// A DFT at a frequency w radians per sample, over a window of the last n samples.
+struct sdft_dft {
+	double s[2];  // DFT of the window, with the phase of each sample relative to the first ever.
+	double p[2];  // e^(-jwt) of the next sample t to arrive.
+	double dp[2];  // e^(-jw), what the phasor is multiplied by for each sample.
+	double c[2];  // e^(jwn), the phasor of the sample leaving the window relative to p.
+};
+
+// The bin of a note, whose DFTs all slide over the same window of n samples.
+struct sdft_bin {
+	struct sdft_dft dfts[NDFTS];
+	uint n;
+	double freq;
+};
+
+struct sdft {
+	struct sdft_bin *bins;
+	uint nbins;
+	uint nnotes;  // Number of notes estimated, from bin 1 up, with a bin below and above for interpolating.
+	uint *harmonics;  // Bins above that of a note of each of its harmonics, hps_order of them.
+	uint hps_order;
+	real_t *ring;  // Ring of the last samples, enough for the longest window, and a block of new ones.
+	uint mask;  // Size of the ring less 1, a power of 2.
+	uint blocksz;  // Most new samples converted into the ring at a time, leaving those still in windows.
+	uint pos;  // Position in the ring of the next sample, wrapping with the mask.
+	real_t *logmag;  // Log of the amplitude of each bin.
+	double silence;  // Amplitude of silence in the units of the samples, SDFT_SILENCE of full scale.
+	real_t floor;  // Log of the amplitude of silence, for harmonics above the highest bin.
+};
+
+/*
+ * note_freq - Get the frequency of a note of equal temperament, where 69 is A4
+ */
+static double note_freq(int note)
+{
+	return A4_FREQ*pow(2, (note-A4_NOTE)/12.0);
+}
+
+/*
+ * nearest_note - Get the number of the note nearest to a frequency
+ */
+static int nearest_note(double freq)
+{
+	return lround(12*log2(freq/A4_FREQ)) + A4_NOTE;
+}
+
+static void sdft_free(fdata_t *f)
+{
+	struct sdft *s = f->priv;
+
+	if (s) {
+		free(s->bins);
+		free(s->harmonics);
+		free(s->ring);
+		free(s->logmag);
+		free(s);
+		f->priv = NULL;
+	}
+}
+
+static void bin_init(struct sdft_bin *b, double freq, uint sample_rate)
+{
+	struct sdft_dft *d;
+	double w;
+
+	b->freq = freq;
+	b->n = lround(SDFT_PERIODS*sample_rate/freq);
+	for (int i = 0; i < NDFTS; ++i) {
+		d = &b->dfts[i];
+		w = 2*M_PI*freq/sample_rate + 2*M_PI*(i-1)/b->n;
+		d->s[0] = d->s[1] = 0;
+		d->p[0] = 1;
+		d->p[1] = 0;
+		d->dp[0] = cos(w);
+		d->dp[1] = -sin(w);
+		d->c[0] = cos(w*b->n);
+		d->c[1] = sin(w*b->n);
+	}
+}
+
+static bool sdft_init(fdata_t *f, struct fdata_params *p, unsigned planner_flags)
+{
+	struct sdft *s;
+	int lowest, highest;
+	uint ringsz = 1, maxn;
+
+	if (p->min_freq <= 0 || p->max_freq < p->min_freq) {
+		eprintf("the sliding DFT needs the range of frequencies of the notes to estimate");
+		return false;
+	}
+	if (p->hps_order < 1) {
+		eprintf("harmonic product spectrum order must be at least 1");
+		return false;
+	}
+	if (!(s = f->priv = calloc(1, sizeof(struct sdft))))
+		goto sdft_init_error;
+	lowest = nearest_note(p->min_freq);
+	highest = nearest_note(p->max_freq);
+	s->nnotes = highest-lowest+1;
+	s->hps_order = p->hps_order;
+	if (!(s->harmonics = malloc(s->hps_order*sizeof(uint))))
+		goto sdft_init_error;
+	for (uint h = 0; h < s->hps_order; ++h)
+		s->harmonics[h] = lround(12*log2(h+1));
+	// A bin below the lowest note and one above the highest for interpolating, and one for
+	// each note the harmonics of the highest land on, up to those past half the sample rate.
+	s->nbins = s->nnotes + 1 + (s->harmonics[s->hps_order-1] > 1 ? s->harmonics[s->hps_order-1] : 1);
+	while (s->nbins > s->nnotes+2 && note_freq(lowest-1+s->nbins-1) >= f->sample_rate/2.0)
+		--s->nbins;
+	if (note_freq(lowest-1+s->nbins-1) >= f->sample_rate/2.0) {
+		eprintf("max frequency %.2f too close to half the sample rate", p->max_freq);
+		return false;
+	}
+	if (!(s->bins = malloc(s->nbins*sizeof(struct sdft_bin))) ||
+	    !(s->logmag = malloc(s->nbins*sizeof(real_t))))
+		goto sdft_init_error;
+	for (uint b = 0; b < s->nbins; ++b)
+		bin_init(&s->bins[b], note_freq(lowest-1+b), f->sample_rate);
+	// The lowest bin has the longest window, and the ring is twice as long, so that blocks of
+	// new samples at least as long as it don't overwrite samples still in a window.
+	maxn = s->bins[0].n;
+	while (ringsz < 2*maxn)
+		ringsz *= 2;
+	s->mask = ringsz-1;
+	s->blocksz = ringsz-maxn;
+	if (!(s->ring = calloc(ringsz, sizeof(real_t))))
+		goto sdft_init_error;
+	s->silence = SDFT_SILENCE;
+	s->floor = log(s->silence);
+	return true;
+
+sdft_init_error:
+	eprintf("failed to init sliding DFT: %s", strerror(errno));
+	return false;
+}
+
+/*
+ * dft_slide - Slide a DFT's window of n samples over a block of new samples in the ring
+ * @pos: position in the ring of the first new sample
+ * @nnew: number of new samples
+ */
+static void dft_slide(struct sdft_dft *d, const real_t *ring, uint mask, uint pos, uint n,
+		      uint nnew)
+{
+	double sr = d->s[0], si = d->s[1], pr = d->p[0], pi = d->p[1], t;
+	double x, old, dr, di, mag;
+
+	for (uint i = 0; i < nnew; ++i, ++pos) {
+		x = ring[pos & mask];
+		old = ring[(pos-n) & mask];
+		// s += p*(x - c*old)
+		dr = x - d->c[0]*old;
+		di = -d->c[1]*old;
+		sr += pr*dr - pi*di;
+		si += pr*di + pi*dr;
+		t = pr*d->dp[0] - pi*d->dp[1];
+		pi = pr*d->dp[1] + pi*d->dp[0];
+		pr = t;
+	}
+	// Keep the phasor from drifting off the unit circle with rounding.
+	mag = hypot(pr, pi);
+	d->p[0] = pr/mag;
+	d->p[1] = pi/mag;
+	d->s[0] = sr;
+	d->s[1] = si;
+}
+
+/*
+ * bin_magnitude - Get the amplitude of the Hann windowed DFT of a note's bin
+ *
+ * Rotating each DFT back by the phasor of the next sample gives it the phase of the window's
+ * samples relative to the window rather than to the first sample ever, and then the Hann
+ * window, 0.5 - 0.5cos(2*pi*m/n) at sample m of the window, is the sum of half the DFT at the
+ * bin less a quarter of those either side of it.
+ */
+static double bin_magnitude(struct sdft_bin *b)
+{
+	static const double hann[NDFTS] = { -0.25, 0.5, -0.25 };
+	struct sdft_dft *d;
+	double re = 0, im = 0;
+
+	for (int i = 0; i < NDFTS; ++i) {
+		d = &b->dfts[i];
+		// hann*s*conj(p)
+		re += hann[i]*(d->s[0]*d->p[0] + d->s[1]*d->p[1]);
+		im += hann[i]*(d->s[1]*d->p[0] - d->s[0]*d->p[1]);
+	}
+	// A sine of amplitude A peaks at A*n/4 in its Hann windowed bin.
+	return 4*hypot(re, im)/b->n;
+}
+
+static void sdft_update(fdata_t *f, char *samples, uint start, uint n, sdtype_meta_t *meta,
+			struct timespec *last)
+{
+	struct sdft *s = f->priv;
+	uint blk;
+
+	while (n) {
+		// A block can't wrap around the chunk's circular buffer or the ring.
+		blk = n < s->blocksz ? n : s->blocksz;
+		if (blk > f->chunksz-start)
+			blk = f->chunksz-start;
+		if (blk > s->mask+1 - (s->pos & s->mask))
+			blk = s->mask+1 - (s->pos & s->mask);
+		normalise_samples_copy(samples+start*meta->samplesz, blk, meta,
+				       s->ring + (s->pos & s->mask));
+		fdata_stage_time(f, FDATA_STAGE_CONVERT, last);
+		for (uint b = 0; b < s->nbins; ++b) {
+			for (int d = 0; d < NDFTS; ++d)
+				dft_slide(&s->bins[b].dfts[d], s->ring, s->mask, s->pos,
+					  s->bins[b].n, blk);
+		}
+		fdata_stage_time(f, FDATA_STAGE_SDFT, last);
+		s->pos += blk;
+		start = (start+blk) % f->chunksz;
+		n -= blk;
+	}
+}
+
+/*
+ * vertex - Get x of the vertex of the parabola through 3 points, or that of the middle one if
+ *	it isn't a peak
+ *
+ * The width of a bin's peak is proportional to its frequency, so bins of notes a semitone
+ * apart aren't evenly spaced in units of their widths, and a parabola through their magnitudes
+ * against the semitones between them would be lopsided. Against the periods of the bins'
+ * notes, in which each peak is the same width, it isn't.
+ */
+static double vertex(const double *x, const double *y)
+{
+	double a = (x[1]-x[0])*(y[1]-y[2]), b = (x[1]-x[2])*(y[1]-y[0]);
+
+	if (y[1] < y[0] || y[1] < y[2] || a == b)
+		return x[1];
+	return x[1] - 0.5*((x[1]-x[0])*a - (x[1]-x[2])*b)/(a-b);
+}
+
+static double sdft_estimate(fdata_t *f, struct timespec *last)
+{
+	struct sdft *s = f->priv;
+	real_t *lm = s->logmag;
+	double score, best_score = -INFINITY, mag, period, x[3], y[3];
+	uint best = 0, k;
+
+	// Samples slide into the DFTs as they are, so silence is relative to their full scale.
+	if (s->silence != SDFT_SILENCE*f->full_scale) {
+		s->silence = SDFT_SILENCE*f->full_scale;
+		s->floor = log(s->silence);
+	}
+	for (uint i = 0; i < s->nbins; ++i) {
+		mag = bin_magnitude(&s->bins[i]);
+		lm[i] = mag > s->silence ? log(mag) : s->floor;
+	}
+	fdata_stage_time(f, FDATA_STAGE_MAGNITUDES, last);
+	// The harmonic product spectrum across the notes, as a sum of logs.
+	for (uint i = 0; i < s->nnotes; ++i) {
+		score = 0;
+		for (uint h = 0; h < s->hps_order; ++h) {
+			k = 1+i+s->harmonics[h];
+			score += k < s->nbins ? lm[k] : s->floor;
+		}
+		if (score > best_score) {
+			best_score = score;
+			best = i;
+		}
+	}
+	fdata_stage_time(f, FDATA_STAGE_HPS, last);
+	k = 1+best;
+	if (lm[k] <= s->floor) {
+		f->peak = 0;
+		fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+		return 0;
+	}
+	f->peak = exp(lm[k])/f->full_scale;
+	if (f->interp == FDATA_INTERP_NONE) {
+		fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+		return s->bins[k].freq;
+	}
+	// As with the harmonic product spectrum of an FFT, the note is only the bin, and a note
+	// about halfway between two peaks in the bin of the other.
+	if (lm[k+1] > lm[k] && k+2 < s->nbins)
+		++k;
+	else if (lm[k-1] > lm[k] && k > 1)
+		--k;
+	for (int i = 0; i < 3; ++i) {
+		x[i] = s->bins[k].freq/s->bins[k-1+i].freq;
+		y[i] = f->interp == FDATA_INTERP_PARABOLIC ? exp(lm[k-1+i]) : lm[k-1+i];
+	}
+	period = vertex(x, y);
+	fdata_stage_time(f, FDATA_STAGE_ARGMAX, last);
+
+	return s->bins[k].freq/period;
+}
+
+const struct fdata_estimator fdata_estimator_sdft = {
+	.name = "sdft",
+	.windowed = false,
+	.init = sdft_init,
+	.update = sdft_update,
+	.estimate = sdft_estimate,
+	.free = sdft_free
+};
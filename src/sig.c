@@ -4,37 +4,63 @@
  * Copyright (C) 2021 Petar Turukalo
  */
 #include "sig.h"
+#include "stats.h"
 
-void sig_block(void)
+static void (*sig_stop)(void);
+static void (*sig_report)(void);
+
+static void sig_set(sigset_t *set)
 {
-	signal(SIGINT, SIG_IGN);
-	signal(SIGTERM, SIG_IGN);
+	sigemptyset(set);
+	sigaddset(set, SIGINT);
+	sigaddset(set, SIGTERM);
+	sigaddset(set, SIGUSR1);
 }
 
-void sighandle(int sig)
+void sig_block(void)
 {
-	// Will call the cleanup function.
-	exit(EXIT_SUCCESS);
+	sigset_t set;
+
+	sig_set(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
 }
 
-/*
- * @sig_handle: signal to set up exit handler for
- * @sig_block: signal to block while handling
- */
-void sig_setup_exit_handle(int sig_handle, int sig_block)
+static void *sig_wait(void *data)
 {
-	struct sigaction sa;
-
-	sa.sa_handler = sighandle;
-	sigemptyset(&sa.sa_mask);
-	sigaddset(&sa.sa_mask, sig_block);
+	sigset_t set;
+	bool stopping = false;
+	int sig;
 
-	sigaction(sig_handle, &sa, NULL);
+	sig_set(&set);
+	for (;;) {
+		if (sigwait(&set, &sig) != 0)
+			continue;
+		if (sig == SIGUSR1) {
+			atomic_fetch_add(&stats_requests, 1);
+			sig_report();
+		} else if (!stopping) {
+			stopping = true;
+			sig_stop();
+		} else {
+			// Without cleaning up, since a tuner that didn't stop may still be using what
+			// would be cleaned up.
+			_exit(EXIT_FAILURE);
+		}
+	}
+	return NULL;
 }
 
-void sig_handle(void)
+bool sig_handle(void (*stop)(void), void (*report)(void))
 {
-	sig_setup_exit_handle(SIGINT, SIGTERM);
-	sig_setup_exit_handle(SIGTERM, SIGINT);
-}
+	pthread_t t;
+	int err;
 
+	sig_stop = stop;
+	sig_report = report;
+	if ((err = pthread_create(&t, NULL, sig_wait, NULL)) != 0) {
+		eprintf("failed to start signal handling thread: %s", strerror(err));
+		return false;
+	}
+	pthread_detach(t);
+	return true;
+}
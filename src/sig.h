@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: GPL-2.0
  *
- * Signal handling for cleaning up the program at exit time.
+ * Signal handling for stopping the program, and for asking it for statistics.
  *
  * Copyright (C) 2021 Petar Turukalo
  */
@@ -10,16 +10,33 @@
 
 #include <signal.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <string.h>
+#include "err.h"
 
 /*
  * sig_block - Block signals so that initialisation of the program
  *	isn't interrupted
+ *
+ * Threads started afterwards inherit the signals blocked, so that they're only received by
+ * the thread started by sig_handle().
  */
 void sig_block(void);
 
 /*
- * sig_handle - Set up signal handlers for exiting and cleaning up the program
+ * sig_handle - Start a thread that handles signals for stopping the program, and for
+ *	printing statistics on SIGUSR1
+ * @stop: called on the first SIGINT or SIGTERM to ask the program to stop. A second one
+ *	exits straight away, for when a tuner is stuck in a read that never returns.
+ * @report: called on SIGUSR1 after stats_requests is bumped, to print the snapshots of
+ *	statistics the tuners answer it with on the signal thread rather than their own
+ *
+ * Signals are waited for on a thread rather than handled in a signal handler, so that stopping
+ * can be run in step with the threads of the tuners rather than interrupt one of them. Return
+ * whether the thread was started.
  */
-void sig_handle(void);
+bool sig_handle(void (*stop)(void), void (*report)(void));
 
 #endif
@@ -0,0 +1,180 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "source.h"
+
+/*
+ * Get the text after a source type prefix, such as the path in "wav:PATH", or NULL
+ * if the spec isn't of the type.
+ */
+static const char *spec_arg(const char *spec, const char *type)
+{
+	size_t n = strlen(type);
+
+	if (strncmp(spec, type, n) != 0)
+		return NULL;
+	if (spec[n] == '\0')
+		return "";
+	return spec[n] == ':' ? spec+n+1 : NULL;
+}
+
+bool source_parse(const char *spec, struct source_params *p)
+{
+	const char *arg;
+	char *end;
+
+	if ((arg = spec_arg(spec, "mic"))) {
+		p->type = SOURCE_MIC;
+		p->device = *arg == '\0' ? NULL : arg;
+	} else if ((arg = spec_arg(spec, "wav")) && *arg != '\0') {
+		p->type = SOURCE_WAV;
+		p->path = arg;
+	} else if ((arg = spec_arg(spec, "raw"))) {
+		p->type = SOURCE_RAW;
+		p->path = *arg == '\0' ? NULL : arg;
+	} else if ((arg = spec_arg(spec, "synth")) && *arg != '\0') {
+		p->type = SOURCE_SYNTH;
+		for (p->synth_nfreqs = 0; ; ++p->synth_nfreqs) {
+			if (p->synth_nfreqs == SYNTH_MAX_CHANNELS) {
+				eprintf("more than %d synthesiser frequencies", SYNTH_MAX_CHANNELS);
+				return false;
+			}
+			p->synth_freqs[p->synth_nfreqs] = strtod(arg, &end);
+			if ((*end != '\0' && *end != ',') || p->synth_freqs[p->synth_nfreqs] <= 0) {
+				eprintf("bad synthesiser frequency %s", arg);
+				return false;
+			}
+			if (*end == '\0')
+				break;
+			arg = end+1;
+		}
+		++p->synth_nfreqs;
+	} else {
+		eprintf("unknown audio source %s", spec);
+		return false;
+	}
+	return true;
+}
+
+bool source_parse_fmt(const char *name, PaSampleFormat *fmt)
+{
+	if (strcmp(name, "float32") == 0)
+		*fmt = paFloat32;
+	else if (strcmp(name, "int32") == 0)
+		*fmt = paInt32;
+	else if (strcmp(name, "int16") == 0)
+		*fmt = paInt16;
+	else {
+		eprintf("unknown sample format %s", name);
+		return false;
+	}
+	return true;
+}
+
+bool source_init(source_t *s, struct source_params *p, uint readsz)
+{
+	PaError samplesz;
+	double freqs[SYNTH_MAX_CHANNELS];
+
+	bzero(s, sizeof(source_t));
+	s->type = p->type;
+	s->sample_rate = p->sample_rate;
+	s->fmt = p->fmt;
+	s->nchannels = p->nchannels;
+	if (!s->nchannels)
+		s->nchannels = p->type == SOURCE_SYNTH ? p->synth_nfreqs : 1;
+
+	switch (p->type) {
+		case SOURCE_MIC:
+			return mic_init(&s->mic, p->sample_rate, readsz, p->fmt, s->nchannels, p->device);
+		case SOURCE_WAV:
+			if (!wav_open(&s->wav, p->path, readsz, s->nchannels))
+				return false;
+			s->sample_rate = s->wav.sample_rate;
+			s->fmt = s->wav.fmt;
+			fprintf(stderr, "using WAV file %s (%u Hz, %u channel(s))\n", p->path,
+				s->sample_rate, s->wav.nchannels);
+			return true;
+		case SOURCE_RAW:
+			samplesz = Pa_GetSampleSize(p->fmt);
+			if (samplesz == paSampleFormatNotSupported) {
+				eprintf("pulse audio sample format %lu: %s", p->fmt,
+					Pa_GetErrorText(paSampleFormatNotSupported));
+				return false;
+			}
+			return raw_open(&s->raw, p->path, samplesz*s->nchannels);
+		case SOURCE_SYNTH:
+			if (s->nchannels > SYNTH_MAX_CHANNELS) {
+				eprintf("synthesiser can't generate more than %d channels", SYNTH_MAX_CHANNELS);
+				return false;
+			}
+			for (uint c = 0; c < s->nchannels; ++c)
+				freqs[c] = p->synth_freqs[c % p->synth_nfreqs];
+			return synth_init(&s->synth, p->sample_rate, freqs, s->nchannels, p->synth_secs,
+					  p->fmt);
+	}
+	return false;
+}
+
+bool source_start(source_t *s)
+{
+	if (s->type == SOURCE_MIC)
+		return mic_start(&s->mic);
+	return true;
+}
+
+bool source_realtime(source_t *s)
+{
+	return s->type == SOURCE_MIC;
+}
+
+bool source_read(source_t *s, char *samples, uint readsz)
+{
+	switch (s->type) {
+		case SOURCE_MIC:
+			mic_read(&s->mic, samples, readsz);
+			return true;
+		case SOURCE_WAV:
+			return wav_read(&s->wav, samples, readsz);
+		case SOURCE_RAW:
+			return raw_read(&s->raw, samples, readsz);
+		case SOURCE_SYNTH:
+			return synth_read(&s->synth, samples, readsz);
+	}
+	return false;
+}
+
+bool source_discontinuity(source_t *s)
+{
+	if (s->type == SOURCE_MIC)
+		return mic_discontinuity(&s->mic);
+	return false;
+}
+
+void source_lost(source_t *s, unsigned long *overruns, unsigned long *overflows)
+{
+	*overruns = *overflows = 0;
+	if (s->type == SOURCE_MIC)
+		mic_lost(&s->mic, overruns, overflows);
+}
+
+void source_cleanup(source_t *s)
+{
+	if (s) {
+		switch (s->type) {
+			case SOURCE_MIC:
+				mic_cleanup(&s->mic);
+				break;
+			case SOURCE_WAV:
+				wav_close(&s->wav);
+				break;
+			case SOURCE_RAW:
+				raw_close(&s->raw);
+				break;
+			case SOURCE_SYNTH:
+				break;
+		}
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Audio input sources. Wraps the microphone, WAV files, raw PCM and the synthesiser
+ * behind the one interface so that the tuner doesn't care where its samples come from.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <portaudio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "err.h"
+#include "mic.h"
+#include "wav.h"
+#include "raw.h"
+#include "synth.h"
+
+typedef enum {
+	SOURCE_MIC,
+	SOURCE_WAV,
+	SOURCE_RAW,
+	SOURCE_SYNTH
+} source_type;
+
+/*
+ * Parameters for initialising a source. Not all are used by every source type.
+ */
+struct source_params {
+	source_type type;
+	const char *path;  // File to read for the WAV and raw sources. NULL for raw is standard input.
+	const char *device;  // Index or part of the name of the microphone's input device, NULL for the default.
+	uint sample_rate;  // Samples per second (Hz). WAV sources take this from the file instead.
+	PaSampleFormat fmt;  // Data type of a sample. WAV sources take this from the file instead.
+	uint nchannels;  // Number of channels, 0 for one per synthesiser frequency or otherwise 1.
+	double synth_freqs[SYNTH_MAX_CHANNELS];  // Frequencies of the notes the synthesiser generates,
+	uint synth_nfreqs;                       // repeated across channels if there are fewer.
+	double synth_secs;  // Number of seconds the synthesiser generates samples for, <= 0 for no end.
+};
+
+struct audio_source {
+	source_type type;
+	union {
+		mic_t mic;
+		wav_t wav;
+		raw_t raw;
+		synth_t synth;
+	};
+	uint sample_rate;  // Actual sample rate of the source.
+	PaSampleFormat fmt;  // Actual data type of a sample of the source.
+	uint nchannels;  // Number of channels of each frame read from the source.
+};
+
+typedef struct audio_source source_t;
+
+/*
+ * source_parse - Parse a source description from the command line into source parameters
+ * @spec: one of "mic", "mic:DEVICE" (an input device's index or part of its name),
+ *	"wav:PATH", "raw", "raw:PATH" or "synth:FREQ[,FREQ...]", a synthesiser with a note per
+ *	channel
+ *
+ * Only the type, path, device and synthesiser frequencies of the parameters are set. Return whether
+ * the description was valid.
+ */
+bool source_parse(const char *spec, struct source_params *p);
+
+/*
+ * source_parse_fmt - Parse a sample format name, one of "float32", "int32" or "int16"
+ */
+bool source_parse_fmt(const char *name, PaSampleFormat *fmt);
+
+/*
+ * source_init - Initialise a source
+ * @readsz: number of frames (a sample of each channel) per read
+ *
+ * The source's actual sample rate, format and number of channels are stored in the source.
+ * Return whether
+ * the initialisation was successful. Clean up with source_cleanup().
+ */
+bool source_init(source_t *s, struct source_params *p, uint readsz);
+
+/*
+ * source_start - Start a source so that it's ready to be read from
+ *
+ * Return whether the source started.
+ */
+bool source_start(source_t *s);
+
+/*
+ * source_realtime - Get whether samples come from a source at the rate they're recorded,
+ *	as opposed to as fast as they can be read
+ */
+bool source_realtime(source_t *s);
+
+/*
+ * source_read - Read samples from a source
+ * @samples: array to store read samples into, with the samples of each frame's channels
+ *	interleaved
+ * @readsz: number of frames to read (preferrably the same as the init-time read size)
+ *
+ * Blocks until the read size amount of frames has been read. Return false if the source
+ * has come to an end, after which it shouldn't be read again.
+ */
+bool source_read(source_t *s, char *samples, uint readsz);
+
+/*
+ * source_discontinuity - Get whether samples have been lost since the last call, so that
+ *	samples read after the loss don't follow on from those read before it
+ *
+ * Only a realtime source can lose samples, when it's read from too slowly.
+ */
+bool source_discontinuity(source_t *s);
+
+/*
+ * source_lost - Get the number of captured buffers a realtime source has lost so far
+ *
+ * See mic_lost(). Both are 0 for sources that can't lose samples.
+ */
+void source_lost(source_t *s, unsigned long *overruns, unsigned long *overflows);
+
+/*
+ * source_cleanup - Clean up a source initialised with source_init
+ */
+void source_cleanup(source_t *s);
+
+#endif
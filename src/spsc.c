@@ -0,0 +1,74 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "spsc.h"
+
+bool spsc_init(spsc_t *r, size_t size)
+{
+	r->size = 1;
+	while (r->size < size)
+		r->size <<= 1;
+	if (!(r->buf = malloc(r->size))) {
+		eprintf("failed to init ring buffer: %s", strerror(errno));
+		return false;
+	}
+	atomic_init(&r->head, 0);
+	atomic_init(&r->tail, 0);
+	return true;
+}
+
+void spsc_free(spsc_t *r)
+{
+	if (r)
+		free(r->buf);
+}
+
+/*
+ * Copy bytes into the ring buffer starting at a free running index, wrapping
+ * around the end of the buffer.
+ */
+static void copy_in(spsc_t *r, size_t i, const char *data, size_t n)
+{
+	size_t off = i & (r->size-1);
+	size_t first = r->size-off < n ? r->size-off : n;
+
+	memcpy(r->buf+off, data, first);
+	memcpy(r->buf, data+first, n-first);
+}
+
+static void copy_out(spsc_t *r, size_t i, char *out, size_t n)
+{
+	size_t off = i & (r->size-1);
+	size_t first = r->size-off < n ? r->size-off : n;
+
+	memcpy(out, r->buf+off, first);
+	memcpy(out+first, r->buf, n-first);
+}
+
+bool spsc_push(spsc_t *r, const void *data, size_t n)
+{
+	size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	// Acquire so that the consumer is done reading the bytes about to be overwritten.
+	size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+	if (r->size-(head-tail) < n)
+		return false;
+	copy_in(r, head, data, n);
+	// Release so that the consumer sees the bytes before it sees the new head.
+	atomic_store_explicit(&r->head, head+n, memory_order_release);
+	return true;
+}
+
+size_t spsc_pop(spsc_t *r, void *out, size_t n)
+{
+	size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+	if (head-tail < n)
+		n = head-tail;
+	copy_out(r, tail, out, n);
+	atomic_store_explicit(&r->tail, tail+n, memory_order_release);
+	return n;
+}
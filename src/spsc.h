@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Lock-free single-producer/single-consumer ring buffer of bytes. One thread may push
+ * while another pops without either taking a lock, which is what's needed to hand samples
+ * from an audio callback, which mustn't block, to the processing thread.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "err.h"
+
+struct spsc_ring {
+	char *buf;
+	size_t size;  // Capacity in bytes, a power of 2 so that indices wrap with a mask.
+	// Free running byte counts of everything pushed and popped. Only the producer stores
+	// to head and only the consumer stores to tail. They're kept on separate cache lines
+	// so the two threads don't bounce the same line between them.
+	_Alignas(64) atomic_size_t head;
+	_Alignas(64) atomic_size_t tail;
+};
+
+typedef struct spsc_ring spsc_t;
+
+/*
+ * spsc_init - Initialise a ring buffer
+ * @size: minimum capacity in bytes, rounded up to a power of 2
+ *
+ * Return whether the initialisation was successful. Free with spsc_free().
+ */
+bool spsc_init(spsc_t *r, size_t size);
+
+/*
+ * spsc_free - Free a ring buffer initialised with spsc_init
+ */
+void spsc_free(spsc_t *r);
+
+/*
+ * spsc_push - Push bytes onto a ring buffer (producer only)
+ * @data: bytes to push
+ * @n: number of bytes to push
+ *
+ * Either all or none of the bytes are pushed. Return false if there wasn't enough space.
+ */
+bool spsc_push(spsc_t *r, const void *data, size_t n);
+
+/*
+ * spsc_pop - Pop bytes from a ring buffer (consumer only)
+ * @out: where to store popped bytes
+ * @n: maximum number of bytes to pop
+ *
+ * Return the number of bytes popped, which is less than n if there weren't enough available.
+ */
+size_t spsc_pop(spsc_t *r, void *out, size_t n);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "stats.h"
+
+atomic_uint stats_requests = 0;
+
+static const char *stage_names[STATS_NSTAGES] = {
+	[STATS_READ] = "read",
+	[STATS_NOTE] = "note",
+	[STATS_OUTPUT] = "output",
+	[STATS_HOP] = "hop",
+};
+
+/*
+ * hist_bucket - Get the index of the bucket of a latency
+ */
+static uint hist_bucket(uint64_t ns)
+{
+	int e;
+
+	if (ns < HIST_NSUB)
+		return ns;
+	// Power of 2 of the latency, and the top bits of it below the most significant bit.
+	e = 63-__builtin_clzll(ns);
+	return (e-2)*HIST_NSUB + (ns >> (e-3)) - HIST_NSUB;
+}
+
+/*
+ * hist_bucket_min - Get the smallest latency in a bucket
+ */
+static uint64_t hist_bucket_min(uint i)
+{
+	if (i < HIST_NSUB)
+		return i;
+	return (uint64_t)(HIST_NSUB + i%HIST_NSUB) << (i/HIST_NSUB - 1);
+}
+
+void hist_add(hist_t *h, uint64_t ns)
+{
+	++h->count;
+	if (ns > h->max)
+		h->max = ns;
+	++h->buckets[hist_bucket(ns)];
+}
+
+uint64_t hist_percentile(hist_t *h, double p)
+{
+	uint64_t rank = p*h->count, n = 0, max;
+
+	if (!h->count)
+		return 0;
+	if (rank < 1)
+		rank = 1;
+	for (uint i = 0; i < HIST_NBUCKETS; ++i) {
+		n += h->buckets[i];
+		if (n >= rank) {
+			max = i+1 < HIST_NBUCKETS ? hist_bucket_min(i+1)-1 : UINT64_MAX;
+			return max < h->max ? max : h->max;
+		}
+	}
+	return h->max;
+}
+
+void stats_init(stats_t *s)
+{
+	bzero(s, sizeof(stats_t));
+}
+
+uint64_t stats_ns_since(struct timespec *t)
+{
+	struct timespec now;
+	uint64_t ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (now.tv_sec-t->tv_sec)*1000000000LL + now.tv_nsec-t->tv_nsec;
+	*t = now;
+	return ns;
+}
+
+void stats_print(FILE *fp, stats_t *s, unsigned long overruns, unsigned long overflows)
+{
+	hist_t *h;
+	const char *name;
+
+	fprintf(fp, "%-12s %10s %10s %10s %10s\n", "stage", "count", "p50 us", "p99 us", "max us");
+	for (int i = 0; i < STATS_NSTAGES; ++i) {
+		h = &s->stages[i];
+		name = stage_names[i] ? stage_names[i] : fdata_stage_names[i-STATS_FDATA];
+		fprintf(fp, "%-12s %10lu %10.1f %10.1f %10.1f\n", name, (unsigned long)h->count,
+			hist_percentile(h, 0.5)/1e3, hist_percentile(h, 0.99)/1e3, h->max/1e3);
+	}
+	fprintf(fp, "overruns %lu, overflows %lu, retries %lu\n", overruns, overflows,
+		(unsigned long)s->retries);
+	fflush(fp);
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Latency histograms of the stages of the tuner's loop and counts of lost samples, so
+ * that a slow refresh can be traced to capture, processing or output. Recording a latency
+ * is a couple of additions, cheap enough to always be on.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include "freq.h"
+
+// Sub-buckets per power of 2 of a histogram, so that a percentile is within 1/8 of its value.
+#define HIST_NSUB 8
+#define HIST_NBUCKETS ((64-2)*HIST_NSUB)
+
+/*
+ * Histogram of latencies in nanoseconds. Latencies under HIST_NSUB ns get a bucket each, and
+ * each power of 2 above that is split into HIST_NSUB buckets.
+ */
+struct histogram {
+	uint64_t count;
+	uint64_t max;
+	uint64_t buckets[HIST_NBUCKETS];
+};
+
+typedef struct histogram hist_t;
+
+// Stages of the tuner's loop, each with a histogram.
+typedef enum {
+	STATS_READ,  // Reading samples from the source, including waiting for capture.
+	STATS_FDATA,  // First of the FDATA_NSTAGES stages of fdata_process_chunk().
+	STATS_NOTE = STATS_FDATA+FDATA_NSTAGES,  // Converting the frequency into a note.
+	STATS_OUTPUT,  // Printing the note.
+	STATS_HOP,  // Time between printing notes, i.e. the refresh interval.
+	STATS_NSTAGES
+} stats_stage;
+
+struct statistics {
+	hist_t stages[STATS_NSTAGES];
+	uint64_t retries;  // Reads started over because samples were lost in capture.
+};
+
+typedef struct statistics stats_t;
+
+// Number of times a snapshot of statistics has been asked for by a signal. Each tuner copies
+// its own snapshot for the signal thread to print when this changes from the count it last saw.
+extern atomic_uint stats_requests;
+
+/*
+ * hist_add - Add a latency to a histogram
+ */
+void hist_add(hist_t *h, uint64_t ns);
+
+/*
+ * hist_percentile - Get a percentile of the latencies in a histogram
+ * @p: percentile as a fraction, e.g. 0.99 for the 99th percentile
+ *
+ * Return the upper bound of the bucket the percentile falls in, or 0 if the histogram is empty.
+ */
+uint64_t hist_percentile(hist_t *h, double p);
+
+/*
+ * stats_init - Initialise statistics with empty histograms and zero counts
+ */
+void stats_init(stats_t *s);
+
+/*
+ * stats_ns_since - Get the nanoseconds since a time, and set the time to now
+ * @t: a time got from clock_gettime() with CLOCK_MONOTONIC
+ */
+uint64_t stats_ns_since(struct timespec *t);
+
+/*
+ * stats_print - Print a snapshot of statistics: the count, p50, p99 and max of each stage
+ *	in microseconds, and the counters
+ * @overruns: captured buffers dropped because the tuner fell behind
+ * @overflows: captured buffers where the audio input itself overflowed
+ */
+void stats_print(FILE *fp, stats_t *s, unsigned long overruns, unsigned long overflows);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "stream.h"
+
+bool stream_parse_format(const char *spec, stream_format *fmt)
+{
+	if (strcmp(spec, "text") == 0) {
+		*fmt = STREAM_NONE;
+	} else if (strcmp(spec, "jsonl") == 0) {
+		*fmt = STREAM_JSONL;
+	} else if (strcmp(spec, "binary") == 0) {
+		*fmt = STREAM_BINARY;
+	} else {
+		eprintf("unknown output format %s", spec);
+		return false;
+	}
+	return true;
+}
+
+bool stream_init(FILE *fp)
+{
+	// Fully buffered even if it's a terminal, so that records are only written a buffer at a time.
+	if (setvbuf(fp, NULL, _IOFBF, STREAM_BUFSZ) != 0) {
+		eprintf("failed to buffer output");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * write_json_string - Write a string as a JSON string, quoted and escaped
+ */
+static void write_json_string(FILE *fp, const char *s)
+{
+	putc('"', fp);
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fprintf(fp, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(fp, "\\u%04x", *s);
+		else
+			putc(*s, fp);
+	}
+	putc('"', fp);
+}
+
+/*
+ * write_jsonl - Write a record as a line of JSON, whose note and cents are null if there's none
+ */
+static void write_jsonl(FILE *fp, const struct stream_record *r, const char *label)
+{
+	struct note n = { .index = r->note, .octave = r->octave };
+	char note[MAX_NOTE_LEN];
+	int len = 0;
+
+	putc('{', fp);
+	if (label) {
+		fprintf(fp, "\"source\":");
+		write_json_string(fp, label);
+		putc(',', fp);
+	}
+	fprintf(fp, "\"sample\":%" PRIu64 ",\"time\":%.6f,\"read_ns\":%" PRId64 ",\"channel\":%u,"
+		"\"freq\":%.3f,", r->sample, r->sample/(double)r->sample_rate, r->read_ns,
+		r->channel, r->freq);
+	if (r->note >= 0) {
+		note_name(&n, note);
+		// Trim the padding spaces.
+		while (len < MAX_NOTE_LEN && note[len] != ' ')
+			++len;
+		fprintf(fp, "\"note\":\"%.*s\",\"cents\":%.1f,", len, note, r->cents);
+	} else {
+		fprintf(fp, "\"note\":null,\"cents\":null,");
+	}
+	fprintf(fp, "\"peak\":%.4g,\"proc_ns\":%" PRIu64 "}\n", r->peak, r->proc_ns);
+}
+
+void stream_write(FILE *fp, stream_format fmt, const struct stream_record *r, const char *label)
+{
+	struct stream_record none;
+
+	switch (fmt) {
+		case STREAM_JSONL:
+			write_jsonl(fp, r, label);
+			break;
+		case STREAM_BINARY:
+			if (r->note < 0) {
+				none = *r;
+				none.cents = 0;
+				none.octave = 0;
+				r = &none;
+			}
+			fwrite(r, sizeof(*r), 1, fp);
+			break;
+		default:
+			break;
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Machine-readable stream of a tuner's pitch, a record per channel of each processed hop,
+ * for tools downstream of the tuner to read rather than scrape the display. Records are
+ * either JSON Lines or fixed size binary structs, and are buffered so that many are written
+ * per system call however high the rate of hops.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include "note.h"
+#include "err.h"
+
+// Size of the buffer of the stream's file, many records long.
+#define STREAM_BUFSZ (1 << 16)
+
+typedef enum {
+	STREAM_NONE,  // The display, or the pitch track in offline mode, rather than records.
+	STREAM_JSONL,
+	STREAM_BINARY
+} stream_format;
+
+/*
+ * A record of the pitch of a channel over a chunk, written as it is in host byte order by
+ * the binary format, so is the same size on every host. A note index of -1 is no note, when
+ * the frequency isn't in the range of valid notes, and its cents and octave are written as 0.
+ */
+struct stream_record {
+	uint64_t sample;  // Number of frames read from the source up to the end of the chunk.
+	int64_t read_ns;  // Wall clock time the end of the chunk was read, ns since the Unix epoch.
+	uint64_t proc_ns;  // Time processing the chunk into a frequency took.
+	double freq;  // Frequency of the chunk, 0 if none was found.
+	double cents;  // Cents the frequency is sharp (positive) or flat of the note.
+	double peak;  // Strength of the peak the frequency was found from, see fdata_t.
+	uint32_t sample_rate;
+	uint8_t source;  // Index of the tuner's source among those tuned at once, from 0.
+	uint8_t channel;  // Number of the channel of the source, from 1 as in the pitch track, up to 255.
+	int8_t note;  // Semitones of the note above C, see struct note.
+	int8_t octave;
+};
+
+_Static_assert(sizeof(struct stream_record) == 56, "binary stream records must be 56 bytes");
+
+/*
+ * stream_parse_format - Parse an output format from the command line
+ * @spec: "text" for none, "jsonl" or "binary"
+ *
+ * Return whether the format exists.
+ */
+bool stream_parse_format(const char *spec, stream_format *fmt);
+
+/*
+ * stream_init - Buffer a file for writing records to, before anything's written to it
+ */
+bool stream_init(FILE *fp);
+
+/*
+ * stream_write - Write a record to a stream's file, buffered
+ * @label: source of the record written with it as JSON, or NULL to leave it out
+ *
+ * The file isn't locked, so callers writing from multiple threads lock it around their records.
+ */
+void stream_write(FILE *fp, stream_format fmt, const struct stream_record *r, const char *label);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "synth.h"
+
+// Number of harmonics including the fundamental.
+#define NHARMONICS 6
+// Amplitude of each harmonic relative to the one below it.
+#define HARMONIC_DECAY 0.6
+// Seconds between plucks of the string, and time constant of a pluck's decay.
+#define PLUCK_PERIOD 2.0
+#define PLUCK_DECAY 1.5
+#define NOISE_AMPLITUDE 0.01
+// Peak of the sum of all harmonics, used to keep samples within -1 to 1.
+#define PEAK ((1-pow(HARMONIC_DECAY, NHARMONICS))/(1-HARMONIC_DECAY) + NOISE_AMPLITUDE)
+
+bool synth_init(synth_t *s, uint sample_rate, const double *freqs, uint nchannels, double secs,
+		PaSampleFormat fmt)
+{
+	if (fmt != paFloat32 && fmt != paInt32 && fmt != paInt16) {
+		eprintf("synthesiser sample format %lu not supported", fmt);
+		return false;
+	}
+	if (nchannels < 1 || nchannels > SYNTH_MAX_CHANNELS) {
+		eprintf("synthesiser number of channels %u must be between 1 and %d", nchannels,
+			SYNTH_MAX_CHANNELS);
+		return false;
+	}
+	for (uint c = 0; c < nchannels; ++c) {
+		if (freqs[c] <= 0 || freqs[c] >= sample_rate/2.0) {
+			eprintf("synthesiser frequency %f must be between 0 and half the sample rate",
+				freqs[c]);
+			return false;
+		}
+		s->freqs[c] = freqs[c];
+	}
+	s->sample_rate = sample_rate;
+	s->nchannels = nchannels;
+	s->fmt = fmt;
+	s->n = 0;
+	s->nsamples = secs > 0 ? secs*sample_rate : 0;
+	s->noise = 1;
+	return true;
+}
+
+/*
+ * noise - Get the next value of a small linear congruential noise generator, in range -1 to 1
+ */
+static double noise(synth_t *s)
+{
+	s->noise = s->noise*1664525 + 1013904223;
+	return s->noise/(double)UINT32_MAX*2 - 1;
+}
+
+/*
+ * synth_sample - Generate the sample of a note at a time t seconds, in range -1 to 1
+ */
+static double synth_sample(synth_t *s, double freq, double t)
+{
+	double amp = 1, sum = 0;
+	double envelope = exp(-fmod(t, PLUCK_PERIOD)/PLUCK_DECAY);
+
+	for (int h = 1; h <= NHARMONICS; ++h, amp *= HARMONIC_DECAY)
+		sum += amp*sin(2*M_PI*h*freq*t);
+	return (envelope*sum + NOISE_AMPLITUDE*noise(s))/PEAK;
+}
+
+bool synth_read(synth_t *s, char *samples, uint readsz)
+{
+	double x;
+	uint i = 0;
+
+	if (s->nsamples && s->n+readsz > s->nsamples)
+		return false;
+	for (uint f = 0; f < readsz; ++f, ++s->n) {
+		for (uint c = 0; c < s->nchannels; ++c, ++i) {
+			x = synth_sample(s, s->freqs[c], s->n/(double)s->sample_rate);
+
+			switch (s->fmt) {
+				case paFloat32:
+					((float *)samples)[i] = x;
+					break;
+				case paInt32:
+					((int32_t *)samples)[i] = x*INT32_MAX;
+					break;
+				case paInt16:
+					((int16_t *)samples)[i] = x*INT16_MAX;
+					break;
+			}
+		}
+	}
+	return true;
+}
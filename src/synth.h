@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Synthetic guitar-like signal generator, for running and profiling without
+ * an audio input device.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <portaudio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/types.h>
+#include "err.h"
+
+// Maximum number of channels a synthesiser generates, enough for a note per string of any guitar.
+#define SYNTH_MAX_CHANNELS 16
+
+struct synthesiser {
+	uint sample_rate;
+	double freqs[SYNTH_MAX_CHANNELS];  // Fundamental frequency of the note generated in each channel.
+	uint nchannels;
+	PaSampleFormat fmt;
+	uint64_t n;  // Index of the next sample to generate.
+	uint64_t nsamples;  // Total number of samples to generate, 0 for no end.
+	uint32_t noise;  // State of the noise generator.
+};
+
+typedef struct synthesiser synth_t;
+
+/*
+ * synth_init - Initialise a synthesiser
+ * @sample_rate: samples per second (Hz)
+ * @freqs: fundamental frequency of the note to generate in each channel
+ * @nchannels: number of channels, up to SYNTH_MAX_CHANNELS
+ * @secs: number of seconds of samples to generate, or <= 0 to never stop
+ * @fmt: pulse audio's description of the data type of generated samples. One of
+ *	paFloat32, paInt32 or paInt16
+ *
+ * The note is "plucked" every couple of seconds, and made up of its fundamental frequency
+ * and decaying harmonics with a little noise, similar to a guitar string. The same parameters
+ * always generate the same samples. Samples of multiple channels are interleaved, as if each
+ * channel were the pickup of a string of a hexaphonic guitar. Return whether the parameters
+ * were valid.
+ */
+bool synth_init(synth_t *s, uint sample_rate, const double *freqs, uint nchannels, double secs,
+		PaSampleFormat fmt);
+
+/*
+ * synth_read - Generate the next samples
+ * @samples: array to store generated samples into
+ * @readsz: number of frames (a sample of each channel) to generate
+ *
+ * Return false when the set number of seconds of samples has been generated.
+ */
+bool synth_read(synth_t *s, char *samples, uint readsz);
+
+#endif
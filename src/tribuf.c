@@ -0,0 +1,55 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "tribuf.h"
+
+// Set in the middle index when the middle buffer has a value the reader hasn't taken.
+#define TRIBUF_FRESH 4u
+
+bool tribuf_init(tribuf_t *t, size_t size)
+{
+	if (!(t->bufs = calloc(3, size))) {
+		eprintf("failed to init triple buffer: %s", strerror(errno));
+		return false;
+	}
+	t->size = size;
+	t->back = 0;
+	t->front = 1;
+	atomic_init(&t->middle, 2);
+	return true;
+}
+
+void tribuf_free(tribuf_t *t)
+{
+	if (t)
+		free(t->bufs);
+}
+
+void *tribuf_back(tribuf_t *t)
+{
+	return t->bufs + t->back*t->size;
+}
+
+void tribuf_publish(tribuf_t *t)
+{
+	// Release so that the reader sees the value before it sees the buffer is fresh, and
+	// acquire so that the reader is done with the buffer given back.
+	t->back = atomic_exchange_explicit(&t->middle, t->back | TRIBUF_FRESH,
+					   memory_order_acq_rel) & ~TRIBUF_FRESH;
+}
+
+bool tribuf_take(tribuf_t *t)
+{
+	if (!(atomic_load_explicit(&t->middle, memory_order_relaxed) & TRIBUF_FRESH))
+		return false;
+	// Only the writer sets the middle buffer fresh, so it stays fresh until swapped here.
+	t->front = atomic_exchange_explicit(&t->middle, t->front, memory_order_acq_rel) & ~TRIBUF_FRESH;
+	return true;
+}
+
+void *tribuf_front(tribuf_t *t)
+{
+	return t->bufs + t->front*t->size;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Lock-free triple buffer holding the latest value written by one thread for another to
+ * read. The writer fills a buffer of its own and publishes it by swapping it with the
+ * middle buffer, and the reader takes the middle buffer by swapping it with its own, so
+ * neither ever waits for the other. Values the reader doesn't get to before the next is
+ * published are skipped, which is what's wanted for handing the latest notes to a display
+ * that can't keep up with the processing.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TRIBUF_H
+#define TRIBUF_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "err.h"
+
+struct tribuf {
+	char *bufs;  // The three buffers, one after another.
+	size_t size;  // Size of a buffer in bytes.
+	uint back;  // Index of the writer's buffer, only used by the writer.
+	uint front;  // Index of the reader's buffer, only used by the reader.
+	// Index of the middle buffer, with TRIBUF_FRESH set if it was published after the reader
+	// last took it. On a cache line of its own since both threads swap it.
+	_Alignas(64) atomic_uint middle;
+};
+
+typedef struct tribuf tribuf_t;
+
+/*
+ * tribuf_init - Initialise a triple buffer with zeroed buffers
+ * @size: size of a buffer in bytes
+ *
+ * Return whether the initialisation was successful. Free with tribuf_free().
+ */
+bool tribuf_init(tribuf_t *t, size_t size);
+
+/*
+ * tribuf_free - Free a triple buffer initialised with tribuf_init
+ */
+void tribuf_free(tribuf_t *t);
+
+/*
+ * tribuf_back - Get the buffer to write the next value into (writer only)
+ *
+ * The buffer holds whatever value was published in it before, not the last published value.
+ */
+void *tribuf_back(tribuf_t *t);
+
+/*
+ * tribuf_publish - Publish the value written into the back buffer (writer only)
+ */
+void tribuf_publish(tribuf_t *t);
+
+/*
+ * tribuf_take - Take the latest published value if there's a new one (reader only)
+ *
+ * Return whether a new value was taken. Either way, tribuf_front() is the latest value taken.
+ */
+bool tribuf_take(tribuf_t *t);
+
+/*
+ * tribuf_front - Get the buffer of the latest value taken by tribuf_take() (reader only)
+ */
+void *tribuf_front(tribuf_t *t);
+
+#endif
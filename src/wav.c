@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "wav.h"
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+// Size of the "fmt " chunk fields that are read, up to and including the first two
+// bytes of the sub format GUID of the extensible format.
+#define FMT_CHUNK_READSZ 26
+
+/*
+ * le16, le32 - Decode a little endian integer from bytes of a file
+ */
+static uint le16(unsigned char *b) { return b[0] | b[1] << 8; }
+static uint32_t le32(unsigned char *b) { return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24; }
+
+/*
+ * Read a chunk header, the chunk's 4 character id and the size of the chunk's data.
+ */
+static bool read_chunk_header(FILE *fp, char *id, uint32_t *size)
+{
+	unsigned char b[8];
+
+	if (fread(b, sizeof(b), 1, fp) != 1)
+		return false;
+	memcpy(id, b, 4);
+	*size = le32(b+4);
+	return true;
+}
+
+/*
+ * Skip over the data of a chunk. Chunks are padded to an even number of bytes.
+ */
+static bool skip_chunk(FILE *fp, uint32_t size)
+{
+	return fseek(fp, size + (size & 1), SEEK_CUR) == 0;
+}
+
+/*
+ * Convert the format code and bits per sample of a WAV file to a pulse audio sample format.
+ */
+static bool wav_to_pasamplefmt(uint format, uint bits, PaSampleFormat *fmt)
+{
+	if (format == WAVE_FORMAT_PCM && bits == 16)
+		*fmt = paInt16;
+	else if (format == WAVE_FORMAT_PCM && bits == 32)
+		*fmt = paInt32;
+	else if (format == WAVE_FORMAT_IEEE_FLOAT && bits == 32)
+		*fmt = paFloat32;
+	else
+		return false;
+	return true;
+}
+
+static bool read_fmt_chunk(wav_t *w, uint32_t size)
+{
+	unsigned char b[FMT_CHUNK_READSZ];
+	uint format, bits;
+	uint32_t nread = size < sizeof(b) ? size : sizeof(b);
+
+	if (size < 16 || fread(b, nread, 1, w->fp) != 1) {
+		eprintf("malformed WAV fmt chunk");
+		return false;
+	}
+	format = le16(b);
+	w->nchannels = le16(b+2);
+	w->sample_rate = le32(b+4);
+	w->framesz = le16(b+12);
+	bits = le16(b+14);
+	// The real format of an extensible format is in the first two bytes of the sub format GUID.
+	if (format == WAVE_FORMAT_EXTENSIBLE && nread == sizeof(b))
+		format = le16(b+24);
+
+	if (!wav_to_pasamplefmt(format, bits, &w->fmt)) {
+		eprintf("WAV format %#x with %u bits per sample not supported", format, bits);
+		return false;
+	}
+	w->samplesz = bits/8;
+	if (w->nchannels == 0 || w->framesz != w->nchannels*w->samplesz) {
+		eprintf("WAV file has bad channel count %u or frame size %u", w->nchannels, w->framesz);
+		return false;
+	}
+	// Skip the rest of the chunk and its padding byte.
+	return fseek(w->fp, size-nread + (size & 1), SEEK_CUR) == 0;
+}
+
+/*
+ * Read through the chunks of a WAV file up to the start of its sample data.
+ */
+static bool read_header(wav_t *w)
+{
+	unsigned char riff[12];
+	char id[4];
+	uint32_t size;
+	bool have_fmt = false;
+
+	if (fread(riff, sizeof(riff), 1, w->fp) != 1 || memcmp(riff, "RIFF", 4) != 0 ||
+	    memcmp(riff+8, "WAVE", 4) != 0) {
+		eprintf("not a RIFF WAVE file");
+		return false;
+	}
+	while (read_chunk_header(w->fp, id, &size)) {
+		if (memcmp(id, "fmt ", 4) == 0) {
+			if (!read_fmt_chunk(w, size))
+				return false;
+			have_fmt = true;
+		} else if (memcmp(id, "data", 4) == 0) {
+			if (!have_fmt)
+				break;
+			// Files being streamed while written can leave the size unset, so read until
+			// the end of the file.
+			w->ndata = (size == 0 || size == UINT32_MAX) ? UINT64_MAX : size;
+			return true;
+		} else if (!skip_chunk(w->fp, size)) {
+			break;
+		}
+	}
+	eprintf("WAV file is missing its fmt or data chunk");
+	return false;
+}
+
+bool wav_open(wav_t *w, const char *path, uint readsz, uint nchannels)
+{
+	bzero(w, sizeof(wav_t));
+	if (!(w->fp = fopen(path, "rb"))) {
+		eprintf("couldn't open WAV file %s: %s", path, strerror(errno));
+		return false;
+	}
+	if (!read_header(w))
+		goto wav_open_error;
+	if (nchannels > w->nchannels) {
+		eprintf("WAV file %s has %u channel(s), fewer than the %u to read", path, w->nchannels,
+			nchannels);
+		goto wav_open_error;
+	}
+	w->nchannels_read = nchannels;
+	w->nframes = readsz;
+	if (w->nchannels > nchannels && !(w->frames = malloc(readsz*w->framesz))) {
+		eprintf("failed to allocate WAV frame buffer: %s", strerror(errno));
+		goto wav_open_error;
+	}
+	return true;
+
+wav_open_error:
+	fclose(w->fp);
+	return false;
+}
+
+/*
+ * Read frames of multiple channels, picking out the channels read from the start of each
+ * frame. Frames are read a frame buffer at a time.
+ */
+static bool read_channels(wav_t *w, char *samples, uint readsz)
+{
+	uint n, readframesz = w->nchannels_read*w->samplesz;
+	char *frame;
+
+	for (; readsz; readsz -= n) {
+		n = readsz < w->nframes ? readsz : w->nframes;
+		if (fread(w->frames, w->framesz, n, w->fp) != n)
+			return false;
+		frame = w->frames;
+		for (uint i = 0; i < n; ++i, frame += w->framesz, samples += readframesz)
+			memcpy(samples, frame, readframesz);
+	}
+	return true;
+}
+
+bool wav_read(wav_t *w, char *samples, uint readsz)
+{
+	uint64_t nbytes = (uint64_t)readsz*w->framesz;
+
+	if (nbytes > w->ndata)
+		return false;
+	if (w->nchannels == w->nchannels_read) {
+		if (fread(samples, w->framesz, readsz, w->fp) != readsz)
+			return false;
+	} else if (!read_channels(w, samples, readsz)) {
+		return false;
+	}
+	if (w->ndata != UINT64_MAX)
+		w->ndata -= nbytes;
+	return true;
+}
+
+void wav_close(wav_t *w)
+{
+	if (w) {
+		fclose(w->fp);
+		free(w->frames);
+	}
+}
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Reading samples from a WAV (RIFF WAVE) audio file.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef WAV_H
+#define WAV_H
+
+#include <portaudio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "err.h"
+
+struct wav_file {
+	FILE *fp;
+	uint sample_rate;
+	uint nchannels;
+	uint nchannels_read;  // Number of channels read, the first of each frame.
+	PaSampleFormat fmt;  // Data type of a sample, described the same as for the microphone.
+	uint samplesz;  // Size of a single channel's sample in bytes.
+	uint framesz;  // Size of a frame (a sample for each channel) in bytes.
+	uint64_t ndata;  // Number of bytes of sample data left to read.
+	char *frames;  // Buffer to read interleaved frames into before picking out the channels read.
+	uint nframes;  // Number of frames the frame buffer holds.
+};
+
+typedef struct wav_file wav_t;
+
+/*
+ * wav_open - Open a WAV file for reading samples
+ * @path: path to the WAV file
+ * @readsz: number of frames per read
+ * @nchannels: number of channels to read, the first of each frame
+ *
+ * Only PCM 16-bit, PCM 32-bit and IEEE float 32-bit files are supported, which map to the
+ * paInt16, paInt32 and paFloat32 sample formats. Any channels of a file past the number read
+ * are skipped, and it's an error for a file to have fewer. Return whether the file was
+ * successfully opened. Close with wav_close().
+ */
+bool wav_open(wav_t *w, const char *path, uint readsz, uint nchannels);
+
+/*
+ * wav_read - Read samples from a WAV file
+ * @samples: array to store read samples into, interleaved if reading multiple channels
+ * @readsz: number of frames to read
+ *
+ * Return false when there aren't enough frames left in the file to fill the read size.
+ */
+bool wav_read(wav_t *w, char *samples, uint readsz);
+
+/*
+ * wav_close - Close a WAV file opened with wav_open
+ */
+void wav_close(wav_t *w);
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "wisdom.h"
+
+#ifdef GTUNE_FLOAT
+#define PRECISION "float"
+#else
+#define PRECISION "double"
+#endif
+
+/*
+ * fnv1a - Hash a string, with 64-bit FNV-1a
+ */
+static uint64_t fnv1a(const char *s, uint64_t h)
+{
+	for (; *s; ++s) {
+		h ^= (unsigned char)*s;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/*
+ * cpu_id - Hash the description of the CPU in /proc/cpuinfo
+ *
+ * Uses the lines of the first processor that identify its model: the model name on x86,
+ * and the implementer, architecture, variant and part on ARM. 0 if there's no cpuinfo.
+ */
+static uint64_t cpu_id(void)
+{
+	static const char *keys[] = {
+		"vendor_id", "model name", "CPU implementer", "CPU architecture", "CPU variant",
+		"CPU part", "Hardware"
+	};
+	char line[256];
+	uint64_t h = 0xcbf29ce484222325ULL;
+	FILE *fp = fopen("/proc/cpuinfo", "r");
+
+	if (!fp)
+		return 0;
+	// The first blank line ends the first processor.
+	while (fgets(line, sizeof(line), fp) && line[0] != '\n') {
+		for (int i = 0; i < sizeof(keys)/sizeof(keys[0]); ++i) {
+			if (strncmp(line, keys[i], strlen(keys[i])) == 0)
+				h = fnv1a(line, h);
+		}
+	}
+	fclose(fp);
+	return h;
+}
+
+bool wisdom_default_path(char *path, size_t size)
+{
+	const char *cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	struct utsname u;
+	int n;
+
+	if (uname(&u) != 0)
+		strcpy(u.machine, "unknown");
+	if (cache && *cache)
+		n = snprintf(path, size, "%s/gtune/wisdom-%s-%s-%016llx", cache, PRECISION,
+			     u.machine, (unsigned long long)cpu_id());
+	else if (home && *home)
+		n = snprintf(path, size, "%s/.cache/gtune/wisdom-%s-%s-%016llx", home, PRECISION,
+			     u.machine, (unsigned long long)cpu_id());
+	else
+		return false;
+	return n < size;
+}
+
+void wisdom_import(const char *path)
+{
+	FFTW(import_wisdom_from_filename)(path);
+}
+
+/*
+ * mkdirs - Make the directories leading up to a file, as with mkdir -p
+ */
+static bool mkdirs(const char *path)
+{
+	char dir[strlen(path)+1];
+
+	strcpy(dir, path);
+	for (char *p = dir+1; *p; ++p) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+			return false;
+		*p = '/';
+	}
+	return true;
+}
+
+bool wisdom_export(const char *path)
+{
+	char tmp[strlen(path)+sizeof(".tmp")];
+
+	sprintf(tmp, "%s.tmp", path);
+	if (!mkdirs(path) || !FFTW(export_wisdom_to_filename)(tmp) || rename(tmp, path) != 0) {
+		eprintf("failed to write FFTW wisdom to %s", path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Cache of FFTW wisdom, the plans FFTW has measured to be fastest, so that they're
+ * measured once rather than at every start up. Wisdom depends on the precision and the
+ * CPU it was measured on, so each gets its own cache file, and FFTW itself keys the plans
+ * in a file by the size of the transform.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef WISDOM_H
+#define WISDOM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include "real.h"
+#include "err.h"
+
+/*
+ * wisdom_default_path - Get the path of the wisdom cache file for this precision and CPU
+ * @path: out-param path, in $XDG_CACHE_HOME/gtune or ~/.cache/gtune
+ * @size: size of the path buffer
+ *
+ * Return false if there's no cache directory (no $HOME) or the path doesn't fit.
+ */
+bool wisdom_default_path(char *path, size_t size);
+
+/*
+ * wisdom_import - Import the wisdom in a cache file, if it exists
+ *
+ * Wisdom that can't be used, such as from another version of FFTW, is ignored.
+ */
+void wisdom_import(const char *path);
+
+/*
+ * wisdom_export - Export all accumulated wisdom to a cache file, creating its directory
+ *	if needed
+ *
+ * The file is written to a temporary file that's renamed over it, so that a tuner starting
+ * at the same time never imports it half written. Return whether it was written.
+ */
+bool wisdom_export(const char *path);
+
+#endif
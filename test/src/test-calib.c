@@ -0,0 +1,145 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-calib.h"
+
+/*
+ * Assert that budgets parse, keeping what they don't give, and that bad ones don't.
+ */
+static void test_parse(void)
+{
+	struct calib_targets t;
+
+	calib_targets_default(&t);
+	assert(t.cents == 5 && t.hz == 0 && t.latency == 0.5 && t.cpu == 0.5);
+	assert(calib_parse("hz=0.5,cpu=0.25", &t));
+	assert(t.cents == 0 && t.hz == 0.5 && t.latency == 0.5 && t.cpu == 0.25);
+	assert(calib_parse("latency=0.1,cents=2", &t));
+	assert(t.cents == 2 && t.hz == 0 && t.latency == 0.1 && t.cpu == 0.25);
+	assert(!calib_parse("cents", &t));
+	assert(!calib_parse("cents=", &t));
+	assert(!calib_parse("cents=0", &t));
+	assert(!calib_parse("cents=1x", &t));
+	assert(!calib_parse("volume=11", &t));
+}
+
+/*
+ * synth_params - Set the parameters of tuners of a synthesised note, as gtune_params_default()
+ *	would without the rest of the tuner
+ */
+static void synth_params(struct gtune_params *p)
+{
+	bzero(p, sizeof(*p));
+	p->src.type = SOURCE_SYNTH;
+	p->src.sample_rate = 44100;
+	p->src.fmt = paFloat32;
+	p->src.synth_freqs[0] = 110;
+	p->src.synth_nfreqs = 1;
+	p->chunksz = 32768;
+	p->chunk_nsteps = 4;
+	p->min_valid_freq = 20;
+	p->max_valid_freq = 1500;
+	fdata_params_default(&p->freq);
+}
+
+/*
+ * Assert that settings are held to every part of the budget, from made up measurements of
+ * them, and that those refreshing the most often, then taking the least CPU, are preferred.
+ */
+static void test_select(void)
+{
+	struct calib_targets t = { .cents = 5, .latency = 0.5, .cpu = 0.5 };
+	struct calib_config best = { 0 };
+	struct calib_config c = { .sample_rate = 44100, .chunksz = 8192, .nsteps = 4, .error = 2 };
+	struct calib_config more = { .sample_rate = 22050, .chunksz = 1024, .nsteps = 2 };
+
+	// A hop of 1 ms on 2 channels, one after another: 8192/44100 s plus 2 ms of latency and
+	// 4 hops a chunk of 2 channels, 0.0431 of a CPU.
+	assert(calib_within(&c, &t, 1e6, 2, 2));
+	assert(fabs(c.latency - (8192/44100.0 + 0.002)) < 1e-12);
+	assert(fabs(c.cpu - 1e6*2*4*44100/8192/1e9) < 1e-12);
+	c.error = 5.5;
+	assert(!calib_within(&c, &t, 1e6, 2, 2));
+	c.error = 2;
+	t.latency = 0.18;
+	assert(!calib_within(&c, &t, 1e6, 2, 2));
+	t.latency = 0.5;
+	assert(!calib_within(&c, &t, 20e6, 2, 2));
+	t = (struct calib_targets){ .hz = 1, .latency = 0.5, .cpu = 0.5 };
+	assert(!calib_within(&c, &t, 1e6, 2, 2));
+	c.error = 0.5;
+	assert(calib_within(&c, &t, 1e6, 2, 2));
+
+	// Any settings beat none, then those with shorter hops, 1024/2/22050 s against
+	// 8192/4/44100 s.
+	assert(calib_better(&c, &best));
+	best = c;
+	more.cpu = 1;
+	assert(calib_better(&more, &best));
+	assert(!calib_better(&best, &more));
+	// Hops as long as the best's only beat it for less CPU.
+	more = c;
+	more.chunksz *= 2;
+	more.nsteps *= 2;
+	more.cpu = c.cpu/2;
+	assert(calib_better(&more, &best));
+	more.cpu = c.cpu;
+	assert(!calib_better(&more, &best));
+}
+
+/*
+ * Assert that the settings chosen for a generous budget, if the machine keeps within it, are
+ * the budget's latency and accuracy, and that none are chosen for a budget nothing keeps
+ * within. How the settings are timed isn't asserted, since it depends on the machine.
+ */
+static void test_configure(void)
+{
+	struct calib_targets t = { .cents = 10, .latency = 1, .cpu = 1 };
+	struct gtune_params p;
+	double freq, note = 110;
+	uint order;
+	float *samples;
+	synth_t s;
+	fdata_t f;
+
+	synth_params(&p);
+	if (calib_configure(&p, &t, 1)) {
+		assert(p.src.sample_rate == 44100 || p.src.sample_rate == 22050);
+		assert(p.chunksz >= 1024 && p.chunksz/(double)p.src.sample_rate <= t.latency);
+		assert(p.chunk_nsteps >= 1 && p.chunk_nsteps <= p.chunksz);
+		assert(p.freq.hps_order == 3 || p.freq.hps_order == 5);
+		// The settings chosen tune a note as accurately as was asked.
+		p.freq.min_freq = p.min_valid_freq;
+		p.freq.max_freq = p.max_valid_freq;
+		assert(fdata_init(&f, p.src.sample_rate, p.chunksz, &p.freq));
+		assert(synth_init(&s, p.src.sample_rate, &note, 1, 0, paFloat32));
+		assert((samples = malloc(p.chunksz*sizeof(float))));
+		synth_read(&s, (char *)samples, p.chunksz);
+		freq = fdata_process_chunk(&f, (char *)samples, 0, &sdtype_meta_float32, true);
+		assert(fabs(1200*log2(freq/note)) <= t.cents);
+		free(samples);
+		fdata_free(&f);
+	}
+
+	// Estimators without a harmonic product spectrum keep their order, chosen or not.
+	synth_params(&p);
+	p.freq.estimator = &fdata_estimator_mpm;
+	order = p.freq.hps_order;
+	t = (struct calib_targets){ .hz = 1, .latency = 1, .cpu = 1 };
+	calib_configure(&p, &t, 2);
+	assert(p.freq.hps_order == order);
+
+	synth_params(&p);
+	t = (struct calib_targets){ .cents = 0.001, .latency = 0.05, .cpu = 1e-6 };
+	assert(!calib_configure(&p, &t, 1));
+	assert(p.src.sample_rate == 44100 && p.chunksz == 32768 && p.chunk_nsteps == 4);
+}
+
+void test_calib_entry(void)
+{
+	test_parse();
+	test_select();
+	test_configure();
+}
@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the calibration of the tuner's settings to a budget.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_CALIB_H
+#define TEST_CALIB_H
+
+#include <assert.h>
+#include <strings.h>
+#include "../../src/calib.h"
+
+/*
+ * test_calib_entry - Entry point to testing calibration
+ */
+void test_calib_entry(void);
+
+#endif
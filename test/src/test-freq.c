@@ -0,0 +1,376 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-freq.h"
+
+#define SAMPLE_RATE 44100
+#define CHUNKSZ 8192
+#define SMALL_CHUNKSZ 4096
+// Just over 2 periods of low E.
+#define MPM_CHUNKSZ 1200
+
+struct synth_freq_result {
+	double synth_freq;  // Frequency of the synthesised note.
+	double freq;  // Frequency the double-precision pipeline processes it into.
+	char note[MAX_NOTE_LEN];
+};
+
+// Results of the double-precision pipeline without interpolation, which the single-precision
+// (FLOAT=1) build must match exactly.
+static struct synth_freq_result SYNTH_FREQ_RESULTS[] = {
+	{ 82.41,  80.749512, "E2 " },
+	{ 110.00, 107.666016, "A2 " },
+	{ 146.83, 145.349121, "D3 " },
+	{ 196.00, 193.798828, "G3 " },
+	{ 246.94, 247.631836, "B3 " },
+	{ 329.63, 328.381348, "E4 " },
+	{ 440.00, 441.430664, "A4 " },
+	{ 93.00,  91.516113, "F#2" },
+	{ 1000.0, 1001.293945, "B5 " },
+};
+
+static void assert_synth_freq(fdata_t *f, struct synth_freq_result *r, sdtype_meta_t *meta,
+			      PaSampleFormat fmt)
+{
+	synth_t s;
+	char samples[CHUNKSZ*sizeof(float)];
+	char note[MAX_NOTE_LEN];
+	double freq;
+
+	assert(synth_init(&s, SAMPLE_RATE, &r->synth_freq, 1, 0, fmt));
+	assert(synth_read(&s, samples, CHUNKSZ));
+	freq = fdata_process_chunk(f, samples, 0, meta, true);
+	note_from_freq(freq, note);
+	// The frequency is that of a bin, so it's either exactly the same or a whole bin off.
+	assert(fabs(freq-r->freq) < 1e-6);
+	assert(strncmp(note, r->note, MAX_NOTE_LEN) == 0);
+	// The fundamental is the strongest harmonic of the note, and never over full scale.
+	assert(f->peak > 0.2 && f->peak < 1);
+}
+
+/*
+ * Assert that planning with a wisdom cache creates the cache, directories and all, and that
+ * planning again from it leaves it as it is.
+ */
+static void test_wisdom(void)
+{
+	char dir[] = "/tmp/gtune-test-XXXXXX";
+	struct utimbuf old = { 0, 0 };
+	fdata_t f;
+	struct fdata_params p;
+	struct stat st;
+
+	assert(mkdtemp(dir));
+	fdata_params_default(&p);
+	snprintf(p.wisdom_path, sizeof(p.wisdom_path), "%s/cache/wisdom", dir);
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	fdata_free(&f);
+	assert(stat(p.wisdom_path, &st) == 0 && st.st_size > 0);
+	// Planning again imports it, and measures nothing new to write back.
+	assert(utime(p.wisdom_path, &old) == 0);
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	fdata_free(&f);
+	assert(stat(p.wisdom_path, &st) == 0 && st.st_mtime == 0);
+
+	unlink(p.wisdom_path);
+	snprintf(p.wisdom_path, sizeof(p.wisdom_path), "%s/cache", dir);
+	rmdir(p.wisdom_path);
+	rmdir(dir);
+}
+
+#define NTHREADS 4
+
+static void *freq_thread(void *arg)
+{
+	struct synth_freq_result *r = arg;
+	fdata_t f;
+	struct fdata_params p;
+
+	fdata_params_default(&p);
+	p.interp = FDATA_INTERP_NONE;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	assert_synth_freq(&f, r, &sdtype_meta_float32, paFloat32);
+	fdata_free(&f);
+	return NULL;
+}
+
+/*
+ * Assert that frequency data can be planned, processed and freed on multiple threads at once,
+ * as by tuners of different sources run at the same time, while another stays in use.
+ */
+static void test_threads(void)
+{
+	pthread_t t[NTHREADS];
+	fdata_t f;
+	struct fdata_params p;
+
+	fdata_params_default(&p);
+	p.interp = FDATA_INTERP_NONE;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	for (int i = 0; i < NTHREADS; ++i)
+		assert(pthread_create(&t[i], NULL, freq_thread, &SYNTH_FREQ_RESULTS[i]) == 0);
+	for (int i = 0; i < NTHREADS; ++i)
+		pthread_join(t[i], NULL);
+	// The plans of the threads' frequency data being freed leaves this one's alone.
+	assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[0], &sdtype_meta_float32, paFloat32);
+	fdata_free(&f);
+}
+
+#define NSHARED 200
+
+/*
+ * Assert that frequency data of the same FFT share a plan, which is left alone for those still
+ * using it when the others are freed, and that those of different FFTs don't.
+ */
+static void test_shared_plans(void)
+{
+	static fdata_t f[NSHARED];
+	fdata_t small, mpm;
+	struct fdata_params p;
+
+	fdata_params_default(&p);
+	p.interp = FDATA_INTERP_NONE;
+	for (int i = 0; i < NSHARED; ++i) {
+		assert(fdata_init(&f[i], SAMPLE_RATE, CHUNKSZ, &p));
+		assert(f[i].p == f[0].p);
+	}
+	assert(fdata_init(&small, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+	assert(small.p != f[0].p);
+	assert(fdata_parse_estimator("mpm", &p));
+	assert(fdata_init(&mpm, SAMPLE_RATE, CHUNKSZ/2, &p));
+	// The McLeod pitch method's FFT is of the chunk padded to twice its length.
+	assert(mpm.p == f[0].p && mpm.ip);
+	fdata_free(&mpm);
+	fdata_free(&small);
+	for (int i = 0; i < NSHARED-1; ++i)
+		fdata_free(&f[i]);
+	assert_synth_freq(&f[NSHARED-1], &SYNTH_FREQ_RESULTS[0], &sdtype_meta_float32, paFloat32);
+	fdata_free(&f[NSHARED-1]);
+}
+
+/*
+ * Assert that interpolating between bins gets a small chunk, whose bins are 10.8 Hz apart,
+ * within a fraction of a Hz of the synthesised notes.
+ */
+static void test_interp(fdata_interp interp, double max_error)
+{
+	fdata_t f;
+	struct fdata_params p;
+	synth_t s;
+	char samples[SMALL_CHUNKSZ*sizeof(float)];
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+	double freq;
+
+	fdata_params_default(&p);
+	p.interp = interp;
+	assert(fdata_init(&f, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+	for (int i = 0; i < n; ++i) {
+		assert(synth_init(&s, SAMPLE_RATE, &SYNTH_FREQ_RESULTS[i].synth_freq, 1, 0, paFloat32));
+		assert(synth_read(&s, samples, SMALL_CHUNKSZ));
+		freq = fdata_process_chunk(&f, samples, 0, &sdtype_meta_float32, true);
+		assert(fabs(freq-SYNTH_FREQ_RESULTS[i].synth_freq) < max_error);
+	}
+	fdata_free(&f);
+}
+
+/*
+ * Assert that a chunk decimated for notes up to the tuner's highest keeps them accurate, and
+ * that factors which don't divide the chunk are refused.
+ */
+static void test_decimation(void)
+{
+	fdata_t f;
+	struct fdata_params p;
+	synth_t s;
+	char samples[CHUNKSZ*sizeof(float)];
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+	double freq;
+
+	fdata_params_default(&p);
+	p.decimation = 3;
+	assert(!fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+
+	fdata_params_default(&p);
+	p.max_freq = 1500;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	// The 5th harmonic of 1500 Hz is too high for a factor of 4.
+	assert(f.decim == 2 && f.fftsz == CHUNKSZ/2);
+	for (int i = 0; i < n; ++i) {
+		assert(synth_init(&s, SAMPLE_RATE, &SYNTH_FREQ_RESULTS[i].synth_freq, 1, 0, paInt16));
+		assert(synth_read(&s, samples, CHUNKSZ));
+		freq = fdata_process_chunk(&f, samples, 0, &sdtype_meta_int16, true);
+		assert(fabs(freq-SYNTH_FREQ_RESULTS[i].synth_freq) < 0.5);
+	}
+	fdata_free(&f);
+
+	// Lower notes leave room for a larger factor.
+	p.max_freq = 400;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	assert(f.decim == 8);
+	fdata_free(&f);
+}
+
+/*
+ * Assert that limiting the spectrum to the bins of notes between the tuner's lowest and highest
+ * gets the same frequencies as processing all of it, and never one out of the band.
+ */
+static void test_band(void)
+{
+	fdata_t f;
+	struct fdata_params p;
+	synth_t s;
+	char samples[CHUNKSZ*sizeof(float)];
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+	double freq, synth_freq = 1000;
+
+	fdata_params_default(&p);
+	p.interp = FDATA_INTERP_NONE;
+	p.min_freq = 20;
+	p.max_freq = 1500;
+	p.decimation = 1;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	// 20 Hz is in bin 3.7 and 1500 Hz in bin 278.6 of a chunk of 8192 at 44100 Hz.
+	assert(f.min_bin == 3 && f.max_bin == 279 && f.nbins == 280*p.hps_order);
+	for (int i = 0; i < n; ++i) {
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_float32, paFloat32);
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_int16, paInt16);
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_int32, paInt32);
+	}
+	fdata_free(&f);
+
+	p.max_freq = 400;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	assert(synth_init(&s, SAMPLE_RATE, &synth_freq, 1, 0, paFloat32));
+	assert(synth_read(&s, samples, CHUNKSZ));
+	freq = fdata_process_chunk(&f, samples, 0, &sdtype_meta_float32, true);
+	assert(freq >= 20*0.99 && freq <= 400*1.01);
+	fdata_free(&f);
+}
+
+/*
+ * Assert that the McLeod pitch method gets the synthesised notes within a fraction of a Hz
+ * from chunks of only about 2 periods of low E, and finds no frequency in silence.
+ */
+static void test_mpm(void)
+{
+	fdata_t f;
+	struct fdata_params p;
+	synth_t s;
+	char samples[MPM_CHUNKSZ*sizeof(float)];
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+	double freq;
+
+	fdata_params_default(&p);
+	assert(fdata_parse_estimator("mpm", &p) && p.estimator == &fdata_estimator_mpm);
+	assert(!fdata_parse_estimator("yin", &p));
+	p.max_freq = 1500;
+	assert(fdata_init(&f, SAMPLE_RATE, MPM_CHUNKSZ, &p));
+	for (int i = 0; i < n; ++i) {
+		assert(synth_init(&s, SAMPLE_RATE, &SYNTH_FREQ_RESULTS[i].synth_freq, 1, 0, paInt16));
+		assert(synth_read(&s, samples, MPM_CHUNKSZ));
+		freq = fdata_process_chunk(&f, samples, 0, &sdtype_meta_int16, true);
+		assert(fabs(freq-SYNTH_FREQ_RESULTS[i].synth_freq) < 0.5);
+		assert(f.peak > 0.9 && f.peak <= 1);
+	}
+	bzero(samples, sizeof(samples));
+	assert(fdata_process_chunk(&f, samples, 0, &sdtype_meta_int16, true) == 0);
+	assert(f.peak == 0);
+	fdata_free(&f);
+}
+
+/*
+ * sdft_steps - Read a synthesised note into a circular buffer a step at a time, processing the
+ *	whole buffer after each step as the tuner does, and return the last frequency
+ */
+static double sdft_steps(fdata_t *f, synth_t *s, float *samples, uint stepsz, uint nsteps)
+{
+	uint head = 0;
+	double freq = 0;
+
+	for (uint i = 0; i < nsteps; ++i) {
+		assert(synth_read(s, (char *)(samples+head), stepsz));
+		head = (head+stepsz) % SMALL_CHUNKSZ;
+		freq = fdata_process_chunk(f, (char *)samples, head, &sdtype_meta_float32, true);
+	}
+	return freq;
+}
+
+/*
+ * Assert that the sliding DFT gets the synthesised notes within a cent, that sliding over a
+ * chunk in many steps gets the same as in one, and that it finds no frequency in silence.
+ */
+static void test_sdft(void)
+{
+	fdata_t f, g;
+	struct fdata_params p;
+	synth_t s;
+	float samples[SMALL_CHUNKSZ];
+	int16_t quiet[SMALL_CHUNKSZ];
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+	double freq, stepped;
+
+	fdata_params_default(&p);
+	assert(fdata_parse_estimator("sdft", &p));
+	assert(!fdata_init(&f, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+	p.min_freq = 20;
+	p.max_freq = 1500;
+	p.decimation = 2;
+	assert(!fdata_init(&f, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+	p.decimation = 0;
+	for (int i = 0; i < n; ++i) {
+		assert(fdata_init(&f, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+		assert(fdata_init(&g, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+		assert(synth_init(&s, SAMPLE_RATE, &SYNTH_FREQ_RESULTS[i].synth_freq, 1, 0, paFloat32));
+		freq = sdft_steps(&f, &s, samples, SMALL_CHUNKSZ, 8);
+		assert(fabs(1200*log2(freq/SYNTH_FREQ_RESULTS[i].synth_freq)) < 1);
+		assert(f.peak > 0.2 && f.peak < 1);
+		assert(synth_init(&s, SAMPLE_RATE, &SYNTH_FREQ_RESULTS[i].synth_freq, 1, 0, paFloat32));
+		stepped = sdft_steps(&g, &s, samples, SMALL_CHUNKSZ/16, 8*16);
+		assert(fabs(stepped-freq) < 1e-6*freq);
+		fdata_free(&g);
+		fdata_free(&f);
+	}
+	assert(fdata_init(&f, SAMPLE_RATE, SMALL_CHUNKSZ, &p));
+	bzero(samples, sizeof(samples));
+	assert(fdata_process_chunk(&f, (char *)samples, 0, &sdtype_meta_float32, true) == 0);
+	assert(f.peak == 0);
+	// Noise of a couple of the least significant bits of int16 samples is silence too.
+	srand(1);
+	for (uint i = 0; i < SMALL_CHUNKSZ; ++i)
+		quiet[i] = rand()%5-2;
+	fdata_reset(&f);
+	assert(fdata_process_chunk(&f, (char *)quiet, 0, &sdtype_meta_int16, true) == 0);
+	assert(f.peak == 0);
+	fdata_free(&f);
+}
+
+void test_freq_entry(void)
+{
+	fdata_t f;
+	struct fdata_params p;
+	int n = sizeof(SYNTH_FREQ_RESULTS)/sizeof(SYNTH_FREQ_RESULTS[0]);
+
+	fdata_params_default(&p);
+	p.hps_order = 0;
+	assert(!fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	fdata_params_default(&p);
+	p.interp = FDATA_INTERP_NONE;
+	assert(fdata_init(&f, SAMPLE_RATE, CHUNKSZ, &p));
+	for (int i = 0; i < n; ++i) {
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_float32, paFloat32);
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_int16, paInt16);
+		assert_synth_freq(&f, &SYNTH_FREQ_RESULTS[i], &sdtype_meta_int32, paInt32);
+	}
+	fdata_free(&f);
+	test_wisdom();
+	test_threads();
+	test_shared_plans();
+	test_interp(FDATA_INTERP_GAUSSIAN, 0.5);
+	test_interp(FDATA_INTERP_PARABOLIC, 2);
+	test_decimation();
+	test_band();
+	test_mpm();
+	test_sdft();
+}
@@ -0,0 +1,24 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test processing samples into frequencies and notes end to end.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_FREQ_H
+#define TEST_FREQ_H
+
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <utime.h>
+#include "../../src/freq.h"
+#include "../../src/note.h"
+#include "../../src/synth.h"
+
+/*
+ * test_freq_entry - Entry point to testing frequency processing
+ */
+void test_freq_entry(void);
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-kern.h"
+
+// Odd sized, so that every variant has elements left over after its vectors.
+#define KERN_TEST_N 1021
+#define KERN_TEST_RATE 44100
+#define KERN_TEST_CHUNKSZ 8192
+
+static real_t rand_real(void)
+{
+	return rand()/(real_t)RAND_MAX*2-1;
+}
+
+static void test_convert(const kern_t *k)
+{
+	float f32[KERN_TEST_N];
+	int16_t s16[KERN_TEST_N];
+	int32_t s32[KERN_TEST_N];
+	real_t w[KERN_TEST_N], want[KERN_TEST_N], got[KERN_TEST_N];
+	const real_t *ws[] = { NULL, w };
+
+	window_fill(w, KERN_TEST_N, WINDOW_HANN, 0);
+	for (int i = 0; i < KERN_TEST_N; ++i) {
+		f32[i] = rand_real();
+		s16[i] = rand()-RAND_MAX/2;
+		s32[i] = rand()-RAND_MAX/2;
+	}
+	for (uint n = 0; n <= KERN_TEST_N; n += n < 40 ? 1 : 97) {
+		for (int j = 0; j < 2; ++j) {
+			kern_scalar.convert_f32(f32, ws[j], want, n);
+			k->convert_f32(f32, ws[j], got, n);
+			assert(memcmp(want, got, n*sizeof(real_t)) == 0);
+			kern_scalar.convert_s16(s16, ws[j], want, n);
+			k->convert_s16(s16, ws[j], got, n);
+			assert(memcmp(want, got, n*sizeof(real_t)) == 0);
+			kern_scalar.convert_s32(s32, ws[j], want, n);
+			k->convert_s32(s32, ws[j], got, n);
+			assert(memcmp(want, got, n*sizeof(real_t)) == 0);
+		}
+	}
+}
+
+static void test_window(const kern_t *k)
+{
+	real_t w[KERN_TEST_N], want[KERN_TEST_N], got[KERN_TEST_N];
+
+	window_fill(w, KERN_TEST_N, WINDOW_HANN, 0);
+	for (int i = 0; i < KERN_TEST_N; ++i)
+		want[i] = got[i] = rand_real();
+	kern_scalar.window(want, w, KERN_TEST_N);
+	k->window(got, w, KERN_TEST_N);
+	assert(memcmp(want, got, sizeof(want)) == 0);
+}
+
+static void test_decimate(const kern_t *k)
+{
+	// Enough input for the largest factor, every output sample and the taps.
+	real_t in[4*KERN_TEST_N+64], taps[64], w[KERN_TEST_N], want[KERN_TEST_N], got[KERN_TEST_N];
+
+	window_fill(w, KERN_TEST_N, WINDOW_HANN, 0);
+	for (int i = 0; i < sizeof(in)/sizeof(in[0]); ++i)
+		in[i] = rand_real();
+	for (int i = 0; i < 64; ++i)
+		taps[i] = rand_real();
+	// Tap counts that are and aren't a multiple of each variant's vector width.
+	for (uint ntaps = 1; ntaps <= 64; ntaps += ntaps < 20 ? 1 : 11) {
+		for (uint factor = 1; factor <= 4; factor *= 2) {
+			kern_scalar.decimate(in, taps, ntaps, factor, w, want, KERN_TEST_N);
+			k->decimate(in, taps, ntaps, factor, w, got, KERN_TEST_N);
+			for (int i = 0; i < KERN_TEST_N; ++i)
+				assert(fabs(want[i]-got[i]) <= REAL_TOL*ntaps);
+		}
+	}
+}
+
+/*
+ * hps_argmax_want - Get the bin of the max of the harmonic product spectrum the unfused way
+ */
+static uint hps_argmax_want(fft_complex *c, uint lo, uint hi, uint len, uint n)
+{
+	real_t mag[KERN_TEST_N], out[KERN_TEST_N];
+
+	magnitudes(c, mag, len);
+	hps(mag, out, hi+1, len, n);
+	return lo + maxi_real(out+lo, hi-lo+1);
+}
+
+static void test_hps_argmax(const kern_t *k)
+{
+	fft_complex c[KERN_TEST_N];
+	uint los[] = { 0, 3, 37 };
+	uint want;
+
+	for (int i = 0; i < KERN_TEST_N; ++i) {
+		c[i][0] = rand_real();
+		c[i][1] = rand_real();
+	}
+	for (uint n = 1; n <= 6; ++n) {
+		for (uint l = 0; l < sizeof(los)/sizeof(los[0]); ++l) {
+			// Bands of a bin up to more than a block, ending where the last harmonics
+			// are and aren't multiplied in.
+			for (uint hi = los[l]; hi < KERN_TEST_N; hi += hi < los[l]+40 ? 1 : 97) {
+				want = hps_argmax_want(c, los[l], hi, KERN_TEST_N, n);
+				assert(kern_scalar.hps_argmax(c, los[l], hi, KERN_TEST_N, n) == want);
+				assert(k->hps_argmax(c, los[l], hi, KERN_TEST_N, n) == want);
+			}
+		}
+	}
+	// Ties are broken the same way, whichever lanes and blocks they fall in.
+	c[5][0] = c[HPS_BLOCKSZ+9][0] = 3;
+	c[5][1] = c[HPS_BLOCKSZ+9][1] = 4;
+	want = hps_argmax_want(c, 3, KERN_TEST_N-1, KERN_TEST_N, 1);
+	assert(want == HPS_BLOCKSZ+9);
+	assert(kern_scalar.hps_argmax(c, 3, KERN_TEST_N-1, KERN_TEST_N, 1) == want);
+	assert(k->hps_argmax(c, 3, KERN_TEST_N-1, KERN_TEST_N, 1) == want);
+	assert(k->hps_argmax(c, 5, KERN_TEST_N-1, KERN_TEST_N, 1) == 5);
+}
+
+/*
+ * Assert that full scale int32 notes get the same frequencies through the fused harmonic
+ * product spectrum as float32 ones, whose magnitudes overflowed a single-precision product
+ * when raw samples reached it.
+ */
+static void test_hps_int32(const kern_t *k)
+{
+	double notes[] = { 82.41, 110, 329.63, 880 };
+	int32_t samples[KERN_TEST_CHUNKSZ];
+	struct fdata_params p;
+	double want, freq;
+	synth_t s;
+	fdata_t f;
+
+	kern = k;
+	fdata_params_default(&p);
+	p.min_freq = 20;
+	p.max_freq = 1500;
+	p.decimation = 1;
+	assert(fdata_init(&f, KERN_TEST_RATE, KERN_TEST_CHUNKSZ, &p));
+	for (uint i = 0; i < sizeof(notes)/sizeof(notes[0]); ++i) {
+		assert(synth_init(&s, KERN_TEST_RATE, &notes[i], 1, 0, paFloat32));
+		assert(synth_read(&s, (char *)samples, KERN_TEST_CHUNKSZ));
+		want = fdata_process_chunk(&f, (char *)samples, 0, &sdtype_meta_float32, true);
+		assert(synth_init(&s, KERN_TEST_RATE, &notes[i], 1, 0, paInt32));
+		assert(synth_read(&s, (char *)samples, KERN_TEST_CHUNKSZ));
+		freq = fdata_process_chunk(&f, (char *)samples, 0, &sdtype_meta_int32, true);
+		assert(fabs(1200*log2(freq/notes[i])) < 5);
+		assert(fabs(freq-want) < 1e-3);
+	}
+	fdata_free(&f);
+}
+
+void test_kern_entry(void)
+{
+	const kern_t *k;
+
+	srand(1);
+	for (uint i = 0; i < kern_nvariants; ++i) {
+		k = kern_variants[i];
+		if (!k->supported())
+			continue;
+		test_convert(k);
+		test_window(k);
+		test_decimate(k);
+		test_hps_argmax(k);
+		test_hps_int32(k);
+	}
+	assert(kern_init(NULL) && kern->supported());
+	assert(kern_init("scalar") && kern == &kern_scalar);
+}
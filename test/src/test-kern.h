@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_KERN_H
+#define TEST_KERN_H
+
+#include <assert.h>
+#include <stdlib.h>
+#include "../../src/kern.h"
+#include "../../src/freq.h"
+#include "../../src/synth.h"
+#include "test-math.h"
+
+/*
+ * test_kern_entry - Entry point to testing that the SIMD kernels the CPU supports
+ *	match the scalar kernels
+ */
+void test_kern_entry(void);
+
+#endif
@@ -25,7 +25,107 @@ void test_nr_new_range(void)
 	assert_nr_new_range(1, -2, 2, -1, 1, 0.5);
 }
 
+/*
+ * Assert a window is symmetric, peaks at 1 in its centre and stays within 0 to 1.
+ */
+static void assert_window_shape(real_t *w, int n)
+{
+	for (int i = 0; i < n; ++i) {
+		assert(fabs(w[i]-w[n-1-i]) < REAL_TOL);
+		assert(w[i] > -REAL_TOL && w[i] <= 1+REAL_TOL);
+	}
+	assert(fabs(w[n/2]-1) < REAL_TOL);
+}
+
+static void test_window(void)
+{
+	int n = 1025;
+	real_t w[n], a[n];
+
+	window_fill(w, n, WINDOW_HANN, 0);
+	assert_window_shape(w, n);
+	for (int i = 0; i < n; ++i)
+		assert(w[i] == (real_t)hann(i, n));
+
+	window_fill(w, n, WINDOW_BLACKMAN_HARRIS, 0);
+	assert_window_shape(w, n);
+	// Blackman-Harris doesn't quite reach 0 at its ends.
+	assert(fabs(w[0]-6e-5) < 1e-6);
+
+	window_fill(w, n, WINDOW_KAISER, 8.6);
+	assert_window_shape(w, n);
+	// A Kaiser window with beta 0 is rectangular.
+	window_fill(w, n, WINDOW_KAISER, 0);
+	for (int i = 0; i < n; ++i)
+		assert(w[i] == 1);
+
+	window_fill(w, n, WINDOW_HANN, 0);
+	for (int i = 0; i < n; ++i)
+		a[i] = i;
+	window_apply(a, w, n);
+	for (int i = 0; i < n; ++i)
+		assert(a[i] == (real_t)i*(real_t)hann(i, n));
+}
+
+/*
+ * Sample parabolas at -1, 0 and 1 and assert their vertices are found.
+ */
+static void test_parabolic_offset(void)
+{
+	double vertices[] = { 0, 0.25, -0.4, 0.5, -0.5 };
+
+	for (int i = 0; i < sizeof(vertices)/sizeof(vertices[0]); ++i) {
+		double v = vertices[i];
+#define PARABOLA(x) (3 - 2*((x)-v)*((x)-v))
+		assert(fabs(parabolic_offset(PARABOLA(-1), PARABOLA(0), PARABOLA(1)) - v) < 1e-12);
+#undef PARABOLA
+	}
+	// Not a peak.
+	assert(parabolic_offset(1, 0, 1) == 0);
+	assert(parabolic_offset(1, 1, 1) == 0);
+}
+
+/*
+ * Assert a low-pass filter passes 0 Hz unchanged, is symmetric about its middle tap, and
+ * that decimating with it keeps a tone below the cutoff and removes one above it.
+ */
+static void test_lowpass(void)
+{
+#define LOWPASS_N 63
+#define LOWPASS_OUT 256
+	real_t taps[LOWPASS_N], w[LOWPASS_OUT], out[LOWPASS_OUT];
+	real_t in[2*LOWPASS_OUT+LOWPASS_N];
+	double sum = 0, pass = 0, stop = 0;
+
+	lowpass_fill(taps, LOWPASS_N, 0.2, 5.65);
+	for (int i = 0; i < LOWPASS_N; ++i) {
+		sum += taps[i];
+		assert(fabs(taps[i]-taps[LOWPASS_N-1-i]) < REAL_TOL);
+	}
+	assert(fabs(sum-1) < REAL_TOL*LOWPASS_N);
+
+	for (int i = 0; i < LOWPASS_OUT; ++i)
+		w[i] = 1;
+	for (int i = 0; i < sizeof(in)/sizeof(in[0]); ++i)
+		in[i] = sin(2*M_PI*0.05*i);
+	decimate(in, taps, LOWPASS_N, 2, w, out, LOWPASS_OUT);
+	for (int i = 0; i < LOWPASS_OUT; ++i)
+		pass = fmax(pass, fabs(out[i]));
+	for (int i = 0; i < sizeof(in)/sizeof(in[0]); ++i)
+		in[i] = sin(2*M_PI*0.4*i);
+	decimate(in, taps, LOWPASS_N, 2, w, out, LOWPASS_OUT);
+	for (int i = 0; i < LOWPASS_OUT; ++i)
+		stop = fmax(stop, fabs(out[i]));
+	assert(fabs(pass-1) < 0.01);
+	assert(stop < 0.01);
+#undef LOWPASS_N
+#undef LOWPASS_OUT
+}
+
 void test_math_entry(void)
 {
 	test_nr_new_range();
+	test_window();
+	test_parabolic_offset();
+	test_lowpass();
 }
@@ -9,6 +9,13 @@
 #include <assert.h>
 #include "../../src/math.h"
 
+// Tolerance of comparing reals that should be equal but for rounding.
+#ifdef GTUNE_FLOAT
+#define REAL_TOL 1e-6
+#else
+#define REAL_TOL 1e-12
+#endif
+
 /*
  * test_math_entry - Entry point to testing math related
  *	functions
@@ -9,7 +9,7 @@ static void assert_norm(char *samples, int n, sdtype_meta_t *meta,
 			double *expected_norm)
 {
 	bool success;
-	double *actual_norm = calloc(n, sizeof(double));
+	real_t *actual_norm = calloc(n, sizeof(real_t));
 
 	normalise_samples(samples, n, meta, actual_norm);
 	for (int i = 0; i < n; ++i) {
@@ -44,9 +44,61 @@ static void assert_double64_norm(double *samples, double n, double *expected_nor
 	assert_sdtype_norm((char *)samples, n, 8, &sdtype_meta_double64, expected_norm);
 }
 
+/*
+ * Assert that normalising a rotated circular buffer gives the same as normalising
+ * the unrotated samples, and that running a window in the same pass gives the same as
+ * running it afterwards.
+ */
+static void assert_ring_norm(int *samples, int n, int start)
+{
+	real_t *expected_norm = calloc(n, sizeof(real_t));
+	real_t *actual_norm = calloc(n, sizeof(real_t));
+	real_t *window = calloc(n, sizeof(real_t));
+	int *ring = calloc(n, sizeof(int));
+
+	for (int i = 0; i < n; ++i)
+		ring[(start+i)%n] = samples[i];
+	window_fill(window, n, WINDOW_HANN, 0);
+
+	normalise_samples((char *)samples, n, &sdtype_meta_int32, expected_norm);
+	normalise_samples_ring((char *)ring, n, start, &sdtype_meta_int32, NULL, actual_norm);
+	assert(memcmp(expected_norm, actual_norm, n*sizeof(real_t)) == 0);
+	window_apply(expected_norm, window, n);
+	normalise_samples_ring((char *)ring, n, start, &sdtype_meta_int32, window, actual_norm);
+	assert(memcmp(expected_norm, actual_norm, n*sizeof(real_t)) == 0);
+
+	normalise_samples_copy((char *)samples, n, &sdtype_meta_int32, expected_norm);
+	normalise_samples_copy_ring((char *)ring, n, start, &sdtype_meta_int32, NULL, actual_norm);
+	assert(memcmp(expected_norm, actual_norm, n*sizeof(real_t)) == 0);
+	window_apply(expected_norm, window, n);
+	normalise_samples_copy_ring((char *)ring, n, start, &sdtype_meta_int32, window, actual_norm);
+	assert(memcmp(expected_norm, actual_norm, n*sizeof(real_t)) == 0);
+
+	free(ring);
+	free(window);
+	free(actual_norm);
+	free(expected_norm);
+}
+
+static void test_ring_norm(void)
+{
+	int samples[] = { 3, -12, 6, -6, 0, 12, 9, -1 };
+	int n = sizeof(samples)/sizeof(samples[0]);
+
+	for (int start = 0; start < n; ++start)
+		assert_ring_norm(samples, n, start);
+}
+
 void test_norm_entry(void)
 {
 	assert_int32_norm((int[]){ -12, 6, -6, 0, 12 }, 5, (double[]){ -1, 0.5, -0.5, 0, 1 });
 	assert_uint16_norm((unsigned short[]){ 0, 20000, 4000, 12000 }, 4, (double[]){ -1, 1, -0.6, 0.2 });
 	assert_double64_norm((double[]){ 5.5, 6.5, 7.5, 8.5, 9.5 }, 5, (double[]){ -1, -0.5, 0, 0.5, 1 });
+	assert_sdtype_norm((char *)(short[]){ 100, -100, 50, 0 }, 4, 2, &sdtype_meta_int16,
+			   (double[]){ 1, -1, 0.5, 0 });
+	assert_sdtype_norm((char *)(float[]){ 0.25, -0.75, 0.75, -0.25 }, 4, 4, &sdtype_meta_float32,
+			   (double[]){ 1.0/3, -1, 1, -1.0/3 });
+	assert_sdtype_norm((char *)(unsigned int[]){ 10, 30, 20 }, 3, 4, &sdtype_meta_uint32,
+			   (double[]){ -1, 1, 0 });
+	test_ring_norm();
 }
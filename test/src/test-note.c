@@ -97,9 +97,13 @@ static struct note_freq_pair NOTE_FREQ_PAIRS[] = {
 static void assert_freq_to_note(double freq, char *sln_note)
 {
 	char ans[MAX_NOTE_LEN];
+	struct note n;
 
 	note_from_freq(freq, ans);
 	assert(strncmp(ans, sln_note, MAX_NOTE_LEN) == 0);
+	note_nearest(freq, &n);
+	note_name(&n, ans);
+	assert(strncmp(ans, sln_note, MAX_NOTE_LEN) == 0);
 }
 
 static void test_freq_to_note(void)
@@ -115,7 +119,51 @@ static void test_freq_to_note(void)
 	}
 }
 
+static void test_cents(void)
+{
+	struct note n;
+
+	note_nearest(440, &n);
+	assert(n.index == 9 && n.octave == 4 && fabs(n.cents) < 1e-9);
+	note_nearest(445, &n);
+	assert(n.index == 9 && n.octave == 4 && fabs(n.cents-19.56) < 0.01);
+	// A quarter tone flat of E2 is still E2.
+	note_nearest(82.41*pow(2, -0.49/12), &n);
+	assert(n.index == 4 && n.octave == 2 && fabs(n.cents+49) < 0.1);
+}
+
+/*
+ * Assert that the notes of a table at the bins of a chunk of 4096 at 44100 Hz, and between
+ * them, are those of their frequencies within a tenth of a cent from bin 6 up, and that
+ * frequencies outside it are still looked up.
+ */
+static void test_table(void)
+{
+	note_table_t t;
+	struct note want, got;
+	double bin = 44100/4096.0;
+
+	assert(note_table_init(&t, 20, 1500, bin/NOTE_TABLE_STEPS));
+	for (double freq = 6*bin; freq <= 1500; freq += 0.37) {
+		note_nearest(freq, &want);
+		note_table_lookup(&t, freq, &got);
+		assert(fabs(got.cents-want.cents) < 0.1 ||
+		       (fabs(fabs(got.cents)-50) < 0.1 && fabs(fabs(want.cents)-50) < 0.1));
+		assert(fabs(want.cents) > 49.9 ||
+		       (got.index == want.index && got.octave == want.octave));
+	}
+	note_table_lookup(&t, 2000, &got);
+	note_nearest(2000, &want);
+	assert(memcmp(&got, &want, sizeof(got)) == 0);
+	note_table_lookup(&t, 10, &got);
+	note_nearest(10, &want);
+	assert(memcmp(&got, &want, sizeof(got)) == 0);
+	note_table_free(&t);
+}
+
 void test_note_entry(void)
 {
 	test_freq_to_note();
+	test_cents();
+	test_table();
 }
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-pool.h"
+
+#define NJOBS 16
+#define NBATCHES 1000
+
+struct jobs {
+	atomic_uint runs[NJOBS];
+};
+
+static void job(void *arg, uint i)
+{
+	struct jobs *j = arg;
+
+	atomic_fetch_add(&j->runs[i], 1);
+}
+
+/*
+ * Run many batches, with fewer, as many and more threads than jobs, and check every job of
+ * every batch ran exactly once and had finished by the time its batch returned.
+ */
+static void test_batches(uint nthreads)
+{
+	pool_t p;
+	struct jobs j;
+
+	for (int i = 0; i < NJOBS; ++i)
+		atomic_init(&j.runs[i], 0);
+	assert(pool_init(&p, nthreads));
+	for (uint b = 1; b <= NBATCHES; ++b) {
+		// Vary the number of jobs so some are left out of a batch.
+		uint njobs = 1 + b%NJOBS;
+
+		pool_run(&p, job, &j, njobs);
+		for (uint i = 0; i < NJOBS; ++i)
+			assert(atomic_load(&j.runs[i]) == (i < njobs ? 1 : 0));
+		for (uint i = 0; i < NJOBS; ++i)
+			atomic_store(&j.runs[i], 0);
+	}
+	pool_free(&p);
+}
+
+void test_pool_entry(void)
+{
+	test_batches(0);
+	test_batches(3);
+	test_batches(NJOBS-1);
+	test_batches(NJOBS*2);
+}
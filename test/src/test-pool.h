@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the pool of worker threads.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_POOL_H
+#define TEST_POOL_H
+
+#include <assert.h>
+#include <stdatomic.h>
+#include "../../src/pool.h"
+
+/*
+ * test_pool_entry - Entry point to testing the pool of worker threads
+ */
+void test_pool_entry(void);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-pub.h"
+
+// Number of snapshots published by the writer thread.
+#define NHOPS 100000
+
+/*
+ * fill - Fill a snapshot with values all derived from its hop, so a torn one shows
+ */
+static void fill(struct pub_snapshot *s, uint64_t hop)
+{
+	s->hop = hop;
+	s->sample = hop*1024;
+	s->read_ns = hop*3;
+	s->sample_rate = 44100;
+	s->nchannels = PUB_MAX_CHANNELS;
+	for (uint c = 0; c < PUB_MAX_CHANNELS; ++c) {
+		s->channels[c].freq = hop+c;
+		s->channels[c].cents = -(double)hop;
+		s->channels[c].peak = hop*0.5;
+		s->channels[c].note = hop%12;
+		s->channels[c].octave = c;
+	}
+}
+
+static void assert_whole(struct pub_snapshot *s)
+{
+	struct pub_snapshot expected;
+
+	fill(&expected, s->hop);
+	assert(memcmp(s, &expected, sizeof(expected)) == 0);
+}
+
+/*
+ * Assert that nothing is read before the first publication, that readers get what was last
+ * published, and that files that aren't publications aren't opened.
+ */
+static void test_publish_read(char *path)
+{
+	pub_t w, r;
+	struct pub_snapshot s;
+	FILE *fp;
+
+	assert(pub_init(&w, path));
+	assert(pub_open(&r, path));
+	assert(!pub_read(&r, &s));
+	fill(&s, 1);
+	pub_publish(&w, &s);
+	fill(&s, 2);
+	pub_publish(&w, &s);
+	bzero(&s, sizeof(s));
+	assert(pub_read(&r, &s));
+	assert(s.hop == 2);
+	assert_whole(&s);
+	pub_free(&r);
+
+	// A new run starts with nothing published.
+	pub_free(&w);
+	assert(pub_init(&w, path));
+	assert(pub_open(&r, path));
+	assert(!pub_read(&r, &s));
+	pub_free(&r);
+	pub_free(&w);
+
+	assert(fp = fopen(path, "w"));
+	fprintf(fp, "not a publication");
+	fclose(fp);
+	assert(!pub_open(&r, path));
+	unlink(path);
+	assert(!pub_open(&r, path));
+}
+
+static void *writer(void *arg)
+{
+	struct pub_snapshot s;
+
+	for (uint64_t hop = 1; hop <= NHOPS; ++hop) {
+		fill(&s, hop);
+		pub_publish(arg, &s);
+	}
+	return NULL;
+}
+
+/*
+ * Publish from one thread while another reads through a mapping of its own, as a reader
+ * process would, and check every snapshot read is whole and no older than the last.
+ */
+static void test_threads(char *path)
+{
+	pub_t w, r;
+	pthread_t t;
+	struct pub_snapshot s;
+	uint64_t last = 0;
+
+	assert(pub_init(&w, path));
+	assert(pub_open(&r, path));
+	assert(pthread_create(&t, NULL, writer, &w) == 0);
+	while (last < NHOPS) {
+		if (!pub_read(&r, &s)) {
+			sched_yield();
+			continue;
+		}
+		assert_whole(&s);
+		assert(s.hop >= last);
+		last = s.hop;
+	}
+	pthread_join(t, NULL);
+	pub_free(&r);
+	pub_free(&w);
+	unlink(path);
+}
+
+void test_pub_entry(void)
+{
+	char path[] = "/tmp/gtune-test-pub-XXXXXX";
+	int fd;
+
+	assert((fd = mkstemp(path)) >= 0);
+	close(fd);
+	test_publish_read(path);
+	test_threads(path);
+}
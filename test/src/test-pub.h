@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the seqlock guarded publication of the latest pitch.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_PUB_H
+#define TEST_PUB_H
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../src/pub.h"
+
+/*
+ * test_pub_entry - Entry point to testing the publication
+ */
+void test_pub_entry(void);
+
+#endif
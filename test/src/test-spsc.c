@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-spsc.h"
+
+// Number of ints passed from the producer to the consumer thread.
+#define NINTS 200000
+// Largest number of ints pushed or popped at once.
+#define MAX_BATCH 37
+
+static void test_push_pop(void)
+{
+	spsc_t r;
+	char out[8];
+
+	assert(spsc_init(&r, 5));
+	assert(r.size == 8);
+	assert(spsc_pop(&r, out, sizeof(out)) == 0);
+
+	assert(spsc_push(&r, "abcde", 5));
+	// Not enough space left, so nothing is pushed.
+	assert(!spsc_push(&r, "fghi", 4));
+	assert(spsc_pop(&r, out, 3) == 3);
+	assert(memcmp(out, "abc", 3) == 0);
+
+	// Wraps around the end of the buffer.
+	assert(spsc_push(&r, "fghijk", 6));
+	assert(spsc_pop(&r, out, sizeof(out)) == 8);
+	assert(memcmp(out, "defghijk", 8) == 0);
+	spsc_free(&r);
+}
+
+static void *producer(void *arg)
+{
+	spsc_t *r = arg;
+	int batch[MAX_BATCH];
+	int next = 0, n;
+
+	while (next < NINTS) {
+		n = 1 + next%MAX_BATCH;
+		if (n > NINTS-next)
+			n = NINTS-next;
+		for (int i = 0; i < n; ++i)
+			batch[i] = next+i;
+		if (spsc_push(r, batch, n*sizeof(int)))
+			next += n;
+		else
+			sched_yield();
+	}
+	return NULL;
+}
+
+/*
+ * Pass a sequence of ints between two threads in odd sized batches and check they
+ * all arrive in order.
+ */
+static void test_threads(void)
+{
+	spsc_t r;
+	pthread_t t;
+	int batch[MAX_BATCH];
+	int expected = 0;
+	size_t n;
+
+	assert(spsc_init(&r, 64*sizeof(int)));
+	assert(pthread_create(&t, NULL, producer, &r) == 0);
+
+	while (expected < NINTS) {
+		// Pop a whole number of ints, although they may have been pushed in different batches.
+		n = spsc_pop(&r, batch, (1 + expected%MAX_BATCH)*sizeof(int));
+		assert(n%sizeof(int) == 0);
+		if (n == 0)
+			sched_yield();
+		for (size_t i = 0; i < n/sizeof(int); ++i)
+			assert(batch[i] == expected++);
+	}
+	pthread_join(t, NULL);
+	spsc_free(&r);
+}
+
+void test_spsc_entry(void)
+{
+	test_push_pop();
+	test_threads();
+}
@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the lock-free single-producer/single-consumer ring buffer.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_SPSC_H
+#define TEST_SPSC_H
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../../src/spsc.h"
+
+/*
+ * test_spsc_entry - Entry point to testing the ring buffer
+ */
+void test_spsc_entry(void);
+
+#endif
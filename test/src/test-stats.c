@@ -0,0 +1,48 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-stats.h"
+
+/*
+ * Assert a percentile is within the 1/HIST_NSUB resolution of a histogram above it.
+ */
+static void assert_percentile(hist_t *h, double p, uint64_t want)
+{
+	uint64_t got = hist_percentile(h, p);
+
+	assert(got >= want && got <= want+want/HIST_NSUB);
+}
+
+static void test_hist(void)
+{
+	stats_t s;
+	hist_t *h = &s.stages[STATS_HOP];
+
+	stats_init(&s);
+	assert(hist_percentile(h, 0.5) == 0);
+
+	// Small latencies are exact.
+	for (uint64_t ns = 0; ns < HIST_NSUB; ++ns)
+		hist_add(h, ns);
+	assert(hist_percentile(h, 0.5) == HIST_NSUB/2-1);
+	assert(hist_percentile(h, 1) == HIST_NSUB-1);
+
+	stats_init(&s);
+	for (uint64_t ns = 1; ns <= 1000; ++ns)
+		hist_add(h, ns*1000);
+	assert(h->count == 1000 && h->max == 1000000);
+	assert_percentile(h, 0.5, 500000);
+	assert_percentile(h, 0.99, 990000);
+	// Percentiles are never above the max.
+	assert(hist_percentile(h, 1) == 1000000);
+
+	hist_add(h, UINT64_MAX);
+	assert(hist_percentile(h, 1) == UINT64_MAX);
+}
+
+void test_stats_entry(void)
+{
+	test_hist();
+}
@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_STATS_H
+#define TEST_STATS_H
+
+#include <assert.h>
+#include "../../src/stats.h"
+
+/*
+ * test_stats_entry - Entry point to testing statistics
+ */
+void test_stats_entry(void);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-stream.h"
+
+static struct stream_record RECORD = {
+	.sample = 88200,
+	.read_ns = 1700000000123456789LL,
+	.proc_ns = 54321,
+	.freq = 110.0049,
+	.cents = -0.34,
+	.peak = 0.5,
+	.sample_rate = 44100,
+	.source = 1,
+	.channel = 2,
+	.note = 9,
+	.octave = 2
+};
+
+static void test_parse(void)
+{
+	stream_format fmt;
+
+	assert(stream_parse_format("jsonl", &fmt) && fmt == STREAM_JSONL);
+	assert(stream_parse_format("binary", &fmt) && fmt == STREAM_BINARY);
+	assert(stream_parse_format("text", &fmt) && fmt == STREAM_NONE);
+	assert(!stream_parse_format("csv", &fmt));
+}
+
+/*
+ * Assert a record and one without a note are written as the lines of JSON expected, with
+ * the source's label escaped.
+ */
+static void test_jsonl(void)
+{
+	struct stream_record r = RECORD;
+	char *buf;
+	size_t len;
+	FILE *fp;
+
+	assert(fp = open_memstream(&buf, &len));
+	stream_write(fp, STREAM_JSONL, &r, "wav:\"a\\b\".wav");
+	r.note = -1;
+	r.freq = 0;
+	r.peak = 0;
+	stream_write(fp, STREAM_JSONL, &r, NULL);
+	assert(fclose(fp) == 0);
+	assert(strcmp(buf,
+		"{\"source\":\"wav:\\\"a\\\\b\\\".wav\",\"sample\":88200,\"time\":2.000000,"
+		"\"read_ns\":1700000000123456789,\"channel\":2,\"freq\":110.005,\"note\":\"A2\","
+		"\"cents\":-0.3,\"peak\":0.5,\"proc_ns\":54321}\n"
+		"{\"sample\":88200,\"time\":2.000000,\"read_ns\":1700000000123456789,\"channel\":2,"
+		"\"freq\":0.000,\"note\":null,\"cents\":null,\"peak\":0,\"proc_ns\":54321}\n") == 0);
+	free(buf);
+}
+
+/*
+ * Assert binary records are written whole, one after another, and read back the same, but for
+ * the cents and octave of one without a note, which are 0 rather than those of the last note.
+ */
+static void test_binary(void)
+{
+	struct stream_record r[3], none = RECORD;
+	FILE *fp;
+
+	none.note = -1;
+	none.freq = 12845.8;
+	assert(fp = tmpfile());
+	stream_write(fp, STREAM_BINARY, &RECORD, "ignored");
+	stream_write(fp, STREAM_BINARY, &RECORD, NULL);
+	stream_write(fp, STREAM_BINARY, &none, NULL);
+	assert(ftell(fp) == 3*sizeof(struct stream_record));
+	rewind(fp);
+	assert(fread(r, sizeof(r[0]), 3, fp) == 3);
+	assert(memcmp(&r[0], &RECORD, sizeof(RECORD)) == 0);
+	assert(memcmp(&r[1], &RECORD, sizeof(RECORD)) == 0);
+	assert(r[2].note == -1 && r[2].freq == 12845.8);
+	assert(r[2].cents == 0 && r[2].octave == 0);
+	none.cents = 0;
+	none.octave = 0;
+	assert(memcmp(&r[2], &none, sizeof(none)) == 0);
+	fclose(fp);
+}
+
+void test_stream_entry(void)
+{
+	test_parse();
+	test_jsonl();
+	test_binary();
+}
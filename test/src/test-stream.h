@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the records of the machine-readable pitch stream.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_STREAM_H
+#define TEST_STREAM_H
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../src/stream.h"
+
+/*
+ * test_stream_entry - Entry point to testing the pitch stream
+ */
+void test_stream_entry(void);
+
+#endif
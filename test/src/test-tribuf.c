@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#include "test-tribuf.h"
+
+// Number of values published by the writer thread.
+#define NVALUES 200000
+// Number of ints in a value, all set to the same count to catch torn reads.
+#define VALUE_LEN 64
+
+static void test_publish_take(void)
+{
+	tribuf_t t;
+
+	assert(tribuf_init(&t, sizeof(int)));
+	// Nothing published yet, and the front buffer starts zeroed.
+	assert(!tribuf_take(&t));
+	assert(*(int *)tribuf_front(&t) == 0);
+
+	*(int *)tribuf_back(&t) = 1;
+	tribuf_publish(&t);
+	assert(tribuf_take(&t));
+	assert(*(int *)tribuf_front(&t) == 1);
+	// Taking again without a new value keeps the last one.
+	assert(!tribuf_take(&t));
+	assert(*(int *)tribuf_front(&t) == 1);
+
+	// Only the latest of values published in between is taken.
+	*(int *)tribuf_back(&t) = 2;
+	tribuf_publish(&t);
+	*(int *)tribuf_back(&t) = 3;
+	tribuf_publish(&t);
+	assert(tribuf_take(&t));
+	assert(*(int *)tribuf_front(&t) == 3);
+	assert(!tribuf_take(&t));
+	tribuf_free(&t);
+}
+
+static void *writer(void *arg)
+{
+	tribuf_t *t = arg;
+	int *v;
+
+	for (int n = 1; n <= NVALUES; ++n) {
+		v = tribuf_back(t);
+		for (int i = 0; i < VALUE_LEN; ++i)
+			v[i] = n;
+		tribuf_publish(t);
+	}
+	return NULL;
+}
+
+/*
+ * Publish a count from one thread while another takes it, and check every value taken is
+ * whole and newer than the last, ending with the last one published.
+ */
+static void test_threads(void)
+{
+	tribuf_t t;
+	pthread_t th;
+	int *v;
+	int last = 0;
+
+	assert(tribuf_init(&t, VALUE_LEN*sizeof(int)));
+	assert(pthread_create(&th, NULL, writer, &t) == 0);
+	while (last < NVALUES) {
+		if (!tribuf_take(&t)) {
+			sched_yield();
+			continue;
+		}
+		v = tribuf_front(&t);
+		for (int i = 1; i < VALUE_LEN; ++i)
+			assert(v[i] == v[0]);
+		assert(v[0] > last);
+		last = v[0];
+	}
+	pthread_join(th, NULL);
+	assert(!tribuf_take(&t));
+	tribuf_free(&t);
+}
+
+void test_tribuf_entry(void)
+{
+	test_publish_take();
+	test_threads();
+}
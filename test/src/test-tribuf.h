@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Test the lock-free triple buffer.
+ *
+ * Copyright (C) 2026 Petar Turukalo
+ */
+#ifndef TEST_TRIBUF_H
+#define TEST_TRIBUF_H
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../../src/tribuf.h"
+
+/*
+ * test_tribuf_entry - Entry point to testing the triple buffer
+ */
+void test_tribuf_entry(void);
+
+#endif
@@ -6,11 +6,29 @@
 #include "test-note.h"
 #include "test-math.h"
 #include "test-norm.h"
+#include "test-spsc.h"
+#include "test-freq.h"
+#include "test-kern.h"
+#include "test-stats.h"
+#include "test-pool.h"
+#include "test-tribuf.h"
+#include "test-stream.h"
+#include "test-pub.h"
+#include "test-calib.h"
 
 int main(void)
 {
 	test_note_entry();
 	test_math_entry();
 	test_norm_entry();
+	test_spsc_entry();
+	test_freq_entry();
+	test_kern_entry();
+	test_stats_entry();
+	test_pool_entry();
+	test_tribuf_entry();
+	test_stream_entry();
+	test_pub_entry();
+	test_calib_entry();
 	return 0;
 }